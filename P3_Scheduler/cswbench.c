@@ -0,0 +1,87 @@
+// Context switch scaling benchmark.
+// Runs NPAIR pairs of processes that bounce a byte over two pipes
+// for BENCHTICKS ticks and reports context switches per second.
+// Run it under "make qemu CPUS=1", 2, 4 and 8 to see how the
+// scheduler scales with the number of cpus.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NPAIR       8
+#define BENCHTICKS  500
+#define TICKHZ      100   // lapic timer ticks per second
+
+// Bounce a byte between this process and a helper child
+// until uptime() reaches end. Returns the number of round trips.
+int
+pingpong(uint end)
+{
+  int ping[2], pong[2];
+  int n;
+  char c;
+
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    printf(1, "cswbench: pipe failed\n");
+    exit();
+  }
+  if(fork() == 0){
+    close(ping[1]);
+    close(pong[0]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit();
+  }
+  close(ping[0]);
+  close(pong[1]);
+
+  c = 'x';
+  for(n = 0; uptime() < end; n++){
+    write(ping[1], &c, 1);
+    read(pong[0], &c, 1);
+  }
+  close(ping[1]);
+  close(pong[0]);
+  wait();
+  return n;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int result[2];
+  int i, n, total;
+  uint start, end;
+
+  if(pipe(result) < 0){
+    printf(1, "cswbench: pipe failed\n");
+    exit();
+  }
+
+  start = uptime();
+  end = start + BENCHTICKS;
+  for(i = 0; i < NPAIR; i++){
+    if(fork() == 0){
+      close(result[0]);
+      n = pingpong(end);
+      write(result[1], &n, sizeof(n));
+      exit();
+    }
+  }
+  close(result[1]);
+
+  total = 0;
+  for(i = 0; i < NPAIR; i++){
+    if(read(result[0], &n, sizeof(n)) != sizeof(n))
+      break;
+    total += n;
+  }
+  for(i = 0; i < NPAIR; i++)
+    wait();
+  end = uptime();
+
+  // Each round trip is two switches: into the helper and back.
+  printf(1, "cswbench: %d pairs, %d switches in %d ticks, %d switches/sec\n",
+         NPAIR, total*2, end - start, total*2*TICKHZ/(end - start));
+  exit();
+}
@@ -78,6 +78,7 @@ int             lapicid(void);
 extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
+void            lapicipi(uchar, int);
 void            lapicstartap(uchar, uint);
 void            microdelay(int);
 
@@ -121,6 +122,13 @@ int             wait(void);
 void            wakeup(void*);
 void            yield(void);
 void            ssu_update_priority();
+int             sched_tick(struct proc *p);
+int             set_sched_class(int sclass);
+int             set_rt_params(uint period, uint budget);
+void            rt_throttle(void);
+void            rt_release_tick(uint now);
+int             resched_pending(void);
+int             getschedstat(int pid, uint *lat, uint *run);
 void            update_priority(struct proc *proc, int priority);
 uint            get_all_cpu_ticks();
 
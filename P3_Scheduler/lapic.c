@@ -113,6 +113,18 @@ lapiceoi(void)
     lapicw(EOI, 0);
 }
 
+// 다른 CPU에 vector 인터럽트(IPI)를 보냄
+void
+lapicipi(uchar apicid, int vector)
+{
+  if(!lapic)
+    return;
+  lapicw(ICRHI, apicid<<24);
+  lapicw(ICRLO, FIXED | ASSERT | vector);
+  while(lapic[ICRLO] & DELIVS)
+    ;
+}
+
 // Spin for a given number of microseconds.
 // On real hardware would want to tune this dynamically.
 void
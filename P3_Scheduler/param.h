@@ -14,3 +14,15 @@
 #define MAXRUNQ      25   // run queue 최대 크기
 #define MAXPRIOR     99   // priority 최대 값
 #define TIMEQUANTUM  30   // tick단위 TQ 값
+#define FAIRSLICE    5    // fair 클래스에서 한 번에 실행하는 tick
+#define SCHED_PRIO   0    // 스케줄링 클래스: 우선순위
+#define SCHED_FAIR   1    // 스케줄링 클래스: fair (vruntime)
+#define SCHED_EDF    2    // 스케줄링 클래스: 실시간 (earliest deadline first)
+#define RTMAXUTIL    950  // CPU마다 실시간 클래스에 승인할 최대 사용률(1/1000 단위)
+#define RTMAXPERIOD  1000000 // 실시간 클래스의 최대 주기(tick). budget*1000이 uint를 넘지 않도록
+#define NSCHEDHIST   32   // 스케줄링 히스토그램 칸 수. i번째 칸은 [2^i, 2^(i+1)) cycle, 마지막 칸은 그 이상 모두
+#ifdef FAIRSCHED          // 부팅 시 init이 사용할 클래스. make sched=fair
+#define SCHED_DEFAULT SCHED_FAIR
+#else
+#define SCHED_DEFAULT SCHED_PRIO
+#endif
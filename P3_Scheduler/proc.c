@@ -4,11 +4,21 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "x86.h"
+#include "traps.h"
 #include "proc.h"
 #include "spinlock.h"
 
-struct run_queue run_queue_list[NPROC]; // 최대 프로세스 개수만큼 할당
-struct run_queue *run_queues[MAXRUNQ]; // 25개의 run queue
+#if MAXRUNQ > 32
+#error "runq.bitmap holds one bit per run queue"
+#endif
+
+uint priority_epoch; // ssu_update_priority가 호출될 때마다 증가하는 aging 주기
+
+// 모든 CPU의 run queue에 대해 priority별 실행 대기 프로세스 수와,
+// 그 수가 0이 아닌 priority가 있는 큐(priority / 4)의 비트맵.
+// get_best_priority가 큐를 탐색하지 않도록 큐에 넣고 뺄 때마다 갱신
+int nrunnable_prio[MAXPRIOR + 1];
+uint runnable_bitmap;
 
 struct {
   struct spinlock lock;
@@ -22,6 +32,7 @@ extern void forkret(void);
 extern void trapret(void);
 
 static void wakeup1(void *chan);
+static void wakeproc(struct proc *p, int flags);
 
 void
 pinit(void)
@@ -91,6 +102,10 @@ allocproc(void)
 found:
   p->state = EMBRYO;
   p->pid = nextpid++;
+  memset(p->lat_hist, 0, sizeof(p->lat_hist));
+  memset(p->run_hist, 0, sizeof(p->run_hist));
+  memset(p->clat_hist, 0, sizeof(p->clat_hist));
+  memset(p->crun_hist, 0, sizeof(p->crun_hist));
 
   release(&ptable.lock);
 
@@ -119,128 +134,733 @@ found:
 }
 
 void
-print_run_queue(int idx)
+print_run_queue(struct runq *rq, int idx)
 {
-  struct run_queue *it; // 순회용
-  if (run_queues[idx] == 0) {
+  struct proc *it; // 순회용
+  if (rq->head[idx] == 0) {
     cprintf("NULL\n");
     return;
   }
   cprintf("RUN Q IDX-%d: ", idx);
-  for (it = run_queues[idx]; it != 0; it = it->next)
-    cprintf("%d -> ", it->rproc->pid);
+  for (it = rq->head[idx]; it != 0; it = it->rq_next)
+    cprintf("%d -> ", it->pid);
   cprintf("NULL\n");
 }
 
 void
 print_run_queues()
 {
-  for (int i=0; i < MAXRUNQ; i++) {
-    if (run_queues[i] == 0)
-      continue;
-    print_run_queue(i);
+  for (int c = 0; c < ncpu; c++) {
+    cprintf("CPU %d:\n", c);
+    for (int i=0; i < MAXRUNQ; i++) {
+      if (cpus[c].rq.head[i] == 0)
+        continue;
+      print_run_queue(&cpus[c].rq, i);
+    }
   }
 }
 
-void
-put_runqueue(struct proc *proc)
+// CPU별 run queue.
+// 각 CPU는 자신의 run queue에서 다음 프로세스를 꺼내고, 프로세스는 마지막으로 실행된
+// CPU(proc->cpu)의 run queue로 돌아간다. 큐가 빈 CPU는 가장 바쁜 CPU에서 훔쳐온다.
+// run queue 안에서는 프로세스의 스케줄링 클래스가 자신의 자료구조로 관리한다.
+// 아래 함수들은 클래스의 tick을 제외하고 모두 ptable.lock 필요. 큐마다 따로 잠금을 두지 않는
+// 것은 ptable.lock이 프로세스 상태와 sleep/wakeup도 보호하며 swtch 동안 잡혀 있어 큐 연산이
+// 어차피 모두 직렬화되기 때문. 큐별 잠금은 프로세스별 잠금이 먼저 있어야 의미가 있음.
+// busiest_cpu, idlest_cpu는 큐 길이만 읽으므로 잠금 없이 ptable.lock을 잡기 전에 부름.
+
+//PAGEBREAK: 30
+// 우선순위(SCHED_PRIO) 클래스: 25개 큐와 비트맵, 주기적인 aging
+
+// aging 주기가 지났다면 재계산한 priority를 반환하고 priority_tick을 초기화.
+// priority_tick은 실행 중일 때만 증가하므로, 주기를 여러 번 놓쳤더라도 처음 놓친
+// 주기에서 한 번만 계산하면 매 주기마다 전체를 갱신하는 것과 같은 값이 된다.
+static int
+aged_priority(struct proc *p)
 {
-  struct run_queue *rq = 0; // 사용할 공간
-  struct run_queue *it; // 순회용
+  int new_priority;
 
-  for (int i = 0; i < NPROC; i++) { // 사용중이지 않은 run_queue 탐색
-    if (!run_queue_list[i].is_used) {
-      rq = &run_queue_list[i];
-      break;
-    }
+  if (p->epoch == priority_epoch) // 이미 반영됨
+    return p->priority;
+  p->epoch = priority_epoch;
+
+  new_priority = p->priority + (p->priority_tick / 10); // 우선순위 값 설정
+  if (p->pid == 1 || p->pid == 2 || new_priority > 99) // IDLEPROC은 고정
+    new_priority = 99;
+  p->priority_tick = 0;
+  return new_priority;
+}
+
+// 현재 실행 대기 중인 프로세스 중 가장 작은 priority. 가장 마지막 큐는 제외하며,
+// 없다면 0. nrunnable_prio와 runnable_bitmap으로 상수 시간에 구함
+int
+get_best_priority(struct proc * target)
+{
+  uint mask = runnable_bitmap & ~(1 << (MAXRUNQ - 1)); // 가장 마지막 큐를 제외
+  int pri;
+
+  if (mask == 0) // 실행 가능한 프로세스가 없다면 0
+    return 0;
+  for (pri = bsf(mask) * 4; nrunnable_prio[pri] == 0; pri++) // 큐 안의 4개 priority 중 탐색
+    ;
+  return pri;
+}
+
+// proc을 자신의 priority에 해당하는 큐에 넣음.
+// 큐는 proc 안의 rq_next, rq_prev로 연결되므로 따로 공간을 할당하지 않는다.
+// ENQ_HEAD면 큐의 맨 앞에 넣는다. 새로 생성되거나 깨어난 프로세스는
+// 같은 큐의 CPU를 오래 쓴 프로세스보다 먼저 스케줄되도록 앞에 넣는다.
+// ENQ_WAKEUP이면 현재 가장 높은 우선순위를 물려받는다.
+static void
+put_runqueue(struct runq *rq, struct proc *proc, int flags)
+{
+  int idx;
+
+  proc->priority = aged_priority(proc);
+  if (flags & ENQ_WAKEUP) {
+    if (proc->pid == 1 || proc->pid == 2) // 만약 idle 프로세스라면 최대 prior 값 부여
+      proc->priority = MAXPRIOR;
+    else // 현재 run_queue에서 관리하는 프로세스중 가장 작은 priority 값 부여
+      proc->priority = get_best_priority(proc);
   }
-  if (!rq)
-    panic("put_runqueue");
 
-  rq->is_used = 1;
-  rq->rproc = proc;
-  rq->next = 0;
+  idx = proc->priority / 4;
+  if (rq->head[idx] == 0) { // 큐의 첫번째가 될 경우
+    proc->rq_prev = proc->rq_next = 0;
+    rq->head[idx] = rq->tail[idx] = proc;
+    rq->bitmap |= 1 << idx;
+  } else if (flags & ENQ_HEAD) {
+    proc->rq_prev = 0;
+    proc->rq_next = rq->head[idx];
+    rq->head[idx]->rq_prev = proc;
+    rq->head[idx] = proc;
+  } else {
+    proc->rq_prev = rq->tail[idx];
+    proc->rq_next = 0;
+    rq->tail[idx]->rq_next = proc;
+    rq->tail[idx] = proc;
+  }
 
-  if (run_queues[proc->priority / 4] == 0) { // 큐의 첫번째가 될 경우
-    run_queues[proc->priority / 4] = rq;
-    return;
+  nrunnable_prio[proc->priority]++;
+  runnable_bitmap |= 1 << idx;
+}
+
+// 모든 CPU에서 idx번 큐에 해당하는 priority의 프로세스가 없는지
+static int
+rq_band_empty(int idx)
+{
+  int *n = &nrunnable_prio[idx * 4];
+
+  return n[0] == 0 && n[1] == 0 && n[2] == 0 && n[3] == 0;
+}
+
+// proc을 큐에서 빼냄. proc->priority로 큐를 찾음.
+static void
+pull_runqueue(struct runq *rq, struct proc *proc)
+{
+  int idx = proc->priority / 4;
+
+  if (proc->rq_prev) // 첫 번째가 아닐 경우
+    proc->rq_prev->rq_next = proc->rq_next;
+  else
+    rq->head[idx] = proc->rq_next;
+  if (proc->rq_next) // 마지막이 아닐 경우
+    proc->rq_next->rq_prev = proc->rq_prev;
+  else
+    rq->tail[idx] = proc->rq_prev;
+  if (rq->head[idx] == 0)
+    rq->bitmap &= ~(1 << idx);
+
+  if (--nrunnable_prio[proc->priority] == 0 && rq_band_empty(idx))
+    runnable_bitmap &= ~(1 << idx);
+
+  // 오류 예방
+  proc->rq_next = proc->rq_prev = 0;
+}
+
+// 비트맵에서 비어있지 않은 가장 앞의 큐의 맨 앞 프로세스
+static struct proc*
+prio_pick_next(struct runq *rq)
+{
+  struct proc *p;
+
+  if (rq->bitmap == 0)
+    return 0;
+  for (;;) {
+    p = rq->head[bsf(rq->bitmap)];
+    if (p->epoch == priority_epoch)
+      return p;
+    // aging 주기가 지난 프로세스는 재계산 후 해당 큐로 옮기고 다시 선택.
+    // 주기마다 한 번씩만 옮겨지므로 반복은 유한함
+    pull_runqueue(rq, p);
+    put_runqueue(rq, p, 0);
   }
+}
 
-  for (it = run_queues[proc->priority / 4]; it->next != 0; it = it->next) {};
+// Time Quantum(30 tick) 마다 스케줄링
+static int
+prio_tick(struct proc *p)
+{
+  p->priority = aged_priority(p); // 지난 aging 주기를 먼저 반영
+  p->priority_tick++;
+  return p->proc_tick % TIMEQUANTUM == 0;
+}
 
-  it->next = rq;
+// 깨어나며 받은 priority가 실행 중인 프로세스보다 좋으면 선점.
+// cur의 priority는 마지막 aging 주기 기준이지만 비교에는 충분함
+static int
+prio_preempt(struct proc *p, struct proc *cur)
+{
+  return p->priority < cur->priority;
 }
 
-void
-pull_runqueue(struct proc *proc)
+struct sched_class prio_sched_class = {
+  .name = "prio",
+  .enqueue = put_runqueue,
+  .dequeue = pull_runqueue,
+  .pick_next = prio_pick_next,
+  .tick = prio_tick,
+  .preempt = prio_preempt,
+};
+
+//PAGEBREAK: 50
+// fair(SCHED_FAIR) 클래스: CPU를 사용한 시간(vruntime)이 가장 적은 프로세스를 실행.
+// run queue마다 vruntime 순서의 AVL 트리를 두고 가장 왼쪽 프로세스를 고른다.
+// vruntime이 같으면 pid로 구분하므로 트리 안의 키는 모두 다르다.
+
+// 오버플로우를 고려해 vruntime을 비교
+static int
+fair_less(struct proc *a, struct proc *b)
 {
-  struct run_queue *bef_it = 0;
-  struct run_queue *it; // 순회용
-  int r_idx = MAXRUNQ; // 발견한 run_queue의 idx
-  
-  // proc에 해당되는 run_queue 탐색
-  for (int i=0; i < MAXRUNQ; i++) { // 전체 RUNQ 탐색.
-    for (it = run_queues[i]; it != 0; it = it->next) { // Q 탐색
-      if (it->rproc == proc) { // 찾았을 경우
-        r_idx = i;
-        break;
-      }
-      bef_it = it;
-    }
-    if (r_idx != MAXRUNQ) // 찾았을경우
-      break;
+  if (a->vruntime != b->vruntime)
+    return (int)(a->vruntime - b->vruntime) < 0;
+  return a->pid < b->pid;
+}
+
+static int
+fair_height(struct proc *n)
+{
+  return n ? n->vheight : 0;
+}
+
+static void
+fair_update(struct proc *n)
+{
+  int l = fair_height(n->vleft), r = fair_height(n->vright);
+
+  n->vheight = (l > r ? l : r) + 1;
+}
+
+static struct proc*
+fair_rotate_right(struct proc *n)
+{
+  struct proc *l = n->vleft;
+
+  n->vleft = l->vright;
+  l->vright = n;
+  fair_update(n);
+  fair_update(l);
+  return l;
+}
+
+static struct proc*
+fair_rotate_left(struct proc *n)
+{
+  struct proc *r = n->vright;
+
+  n->vright = r->vleft;
+  r->vleft = n;
+  fair_update(n);
+  fair_update(r);
+  return r;
+}
+
+// 양쪽 높이 차이가 2 이상이면 회전해서 균형을 맞추고 새 루트를 반환
+static struct proc*
+fair_balance(struct proc *n)
+{
+  int diff;
+
+  fair_update(n);
+  diff = fair_height(n->vleft) - fair_height(n->vright);
+  if (diff > 1) {
+    if (fair_height(n->vleft->vleft) < fair_height(n->vleft->vright))
+      n->vleft = fair_rotate_left(n->vleft);
+    return fair_rotate_right(n);
   }
-  if (it == 0)
-    panic("pull_runqueue");
-  
-  // 큐 조정
-  if (it == run_queues[r_idx]) // 첫 번째 run_queue일 경우
-    run_queues[r_idx] = it->next;
+  if (diff < -1) {
+    if (fair_height(n->vright->vright) < fair_height(n->vright->vleft))
+      n->vright = fair_rotate_right(n->vright);
+    return fair_rotate_left(n);
+  }
+  return n;
+}
+
+static struct proc*
+fair_insert(struct proc *root, struct proc *p)
+{
+  if (root == 0) {
+    p->vleft = p->vright = 0;
+    p->vheight = 1;
+    return p;
+  }
+  if (fair_less(p, root))
+    root->vleft = fair_insert(root->vleft, p);
   else
-    bef_it->next = it->next;
+    root->vright = fair_insert(root->vright, p);
+  return fair_balance(root);
+}
 
-  it->is_used = 0;
-  // 오류 예방
-  it->next = 0;
-  it->rproc = 0;
+// 가장 왼쪽 노드를 떼어 *min에 넣고 새 루트를 반환
+static struct proc*
+fair_remove_min(struct proc *root, struct proc **min)
+{
+  if (root->vleft == 0) {
+    *min = root;
+    return root->vright;
+  }
+  root->vleft = fair_remove_min(root->vleft, min);
+  return fair_balance(root);
 }
 
-int
-get_best_priority(struct proc * target)
+static struct proc*
+fair_remove(struct proc *root, struct proc *p)
+{
+  struct proc *m;
+
+  if (root == 0)
+    panic("fair_remove");
+  if (root == p) {
+    if (p->vright == 0)
+      return p->vleft;
+    p->vright = fair_remove_min(p->vright, &m); // 오른쪽 최소 노드로 대체
+    m->vleft = p->vleft;
+    m->vright = p->vright;
+    return fair_balance(m);
+  }
+  if (fair_less(p, root))
+    root->vleft = fair_remove(root->vleft, p);
+  else
+    root->vright = fair_remove(root->vright, p);
+  return fair_balance(root);
+}
+
+// 오래 잠들었거나 다른 CPU에서 옮겨온 프로세스가 vruntime이 너무 작아 CPU를
+// 독점하지 않도록, 큐의 최소 vruntime보다 FAIRSLICE 이상 뒤처지지 않게 맞춤
+static void
+fair_enqueue(struct runq *rq, struct proc *p, int flags)
+{
+  uint floor = rq->min_vruntime - FAIRSLICE;
+
+  if ((int)(p->vruntime - floor) < 0)
+    p->vruntime = floor;
+  rq->fair_root = fair_insert(rq->fair_root, p);
+}
+
+static void
+fair_dequeue(struct runq *rq, struct proc *p)
 {
-  struct run_queue *q;
-  int best_pri = MAXPRIOR; // 가장 높은 우선순위. MAXPRIOR도 스케줄 되야 하므로
+  rq->fair_root = fair_remove(rq->fair_root, p);
+}
+
+static struct proc*
+fair_pick_next(struct runq *rq)
+{
+  struct proc *p;
+
+  if ((p = rq->fair_root) == 0)
+    return 0;
+  while (p->vleft)
+    p = p->vleft;
+  if ((int)(p->vruntime - rq->min_vruntime) > 0) // min_vruntime은 단조 증가
+    rq->min_vruntime = p->vruntime;
+  return p;
+}
+
+// FAIRSLICE tick 마다 양보. 여전히 vruntime이 가장 작다면 바로 다시 선택된다
+static int
+fair_tick(struct proc *p)
+{
+  p->vruntime++;
+  return p->proc_tick % FAIRSLICE == 0;
+}
 
-  for (int i=0; i < MAXRUNQ - 1; i++) { // 가장 마지막 큐를 제외한 전체 RUNQ 탐색.
-    for (q = run_queues[i]; q != 0; q = q->next) { // 연결 리스트 탐색
-      if (q->rproc-> state == RUNNABLE && q->rproc->priority < best_pri) // 이전 프로세스보다 우선순위가 높을경우
-        best_pri = q->rproc->priority;
+// 실행 중인 프로세스가 한 slice 이상 더 실행했을 때만 선점해 잦은 전환을 막음
+static int
+fair_preempt(struct proc *p, struct proc *cur)
+{
+  return (int)(cur->vruntime - p->vruntime) >= FAIRSLICE;
+}
+
+struct sched_class fair_sched_class = {
+  .name = "fair",
+  .enqueue = fair_enqueue,
+  .dequeue = fair_dequeue,
+  .pick_next = fair_pick_next,
+  .tick = fair_tick,
+  .preempt = fair_preempt,
+};
+
+//PAGEBREAK: 40
+// 실시간(EDF) 클래스
+// 주기(rt_period)마다 rt_budget tick까지 실행할 수 있는 프로세스들을 마감 시간
+// (rt_deadline) 순서로 실행한다. 다른 모든 클래스보다 먼저 선택되며, 깨어나는 즉시
+// 해당 CPU에서 더 늦은 마감의 프로세스를 밀어냄. 예산을 다 쓰면 다음 주기까지
+// rt_throttle에서 잠든다. 프로세스는 승인된 CPU에 고정되어 다른 CPU가 가져가지 않음
+
+uint rt_util[NCPU];            // CPU별로 승인된 실시간 사용률의 합(1/1000 단위)
+volatile int rt_nthrottled;    // 다음 주기를 기다리며 잠든 실시간 프로세스 수
+volatile uint rt_next_release; // 그 중 가장 빠른 다음 주기 시작 시각(tick)
+
+#define RT_UTIL(budget, period) ((budget) * 1000 / (period))
+// a의 마감이 b보다 빠른가. ticks가 넘쳐도 차이로 비교
+#define DEADLINE_BEFORE(a, b) ((int)((a)->rt_deadline - (b)->rt_deadline) < 0)
+
+// 마감 시간 순서의 연결 리스트에 넣음. 실시간 프로세스 수는 적으므로 선형 삽입
+static void
+edf_enqueue(struct runq *rq, struct proc *p, int flags)
+{
+  struct proc *q, *prev = 0;
+
+  // 주기를 넘겨 잠들었다가 깨어났다면 지금부터 새 주기를 시작
+  if ((flags & ENQ_WAKEUP) && (int)(ticks - p->rt_deadline) >= 0) {
+    p->rt_deadline = ticks + p->rt_period;
+    p->rt_used = 0;
+  }
+
+  for (q = rq->edf_head; q && !DEADLINE_BEFORE(p, q); q = q->rq_next)
+    prev = q;
+  p->rq_prev = prev;
+  p->rq_next = q;
+  if (q)
+    q->rq_prev = p;
+  if (prev)
+    prev->rq_next = p;
+  else
+    rq->edf_head = p;
+}
+
+static void
+edf_dequeue(struct runq *rq, struct proc *p)
+{
+  if (p->rq_prev)
+    p->rq_prev->rq_next = p->rq_next;
+  else
+    rq->edf_head = p->rq_next;
+  if (p->rq_next)
+    p->rq_next->rq_prev = p->rq_prev;
+  p->rq_next = p->rq_prev = 0;
+}
+
+static struct proc*
+edf_pick_next(struct runq *rq)
+{
+  return rq->edf_head;
+}
+
+// 예산 소진은 trap()에서 rt_throttle이 처리
+static int
+edf_tick(struct proc *p)
+{
+  p->rt_used++;
+  return 0;
+}
+
+static int
+edf_preempt(struct proc *p, struct proc *cur)
+{
+  return DEADLINE_BEFORE(p, cur);
+}
+
+struct sched_class edf_sched_class = {
+  .name = "edf",
+  .enqueue = edf_enqueue,
+  .dequeue = edf_dequeue,
+  .pick_next = edf_pick_next,
+  .tick = edf_tick,
+  .preempt = edf_preempt,
+  .pinned = 1,
+};
+
+//PAGEBREAK: 40
+// 클래스 공통 부분
+
+// 클래스 번호(SCHED_*)로 찾는 표
+static struct sched_class *sched_classes[] = {
+  [SCHED_PRIO] &prio_sched_class,
+  [SCHED_FAIR] &fair_sched_class,
+  [SCHED_EDF] &edf_sched_class,
+};
+
+// 프로세스를 고를 때 확인하는 클래스 순서. 앞의 클래스가 항상 먼저 실행됨
+static struct sched_class *sched_order[] = {
+  &edf_sched_class,
+  &prio_sched_class,
+  &fair_sched_class,
+};
+
+#define SCLASS(p) (sched_classes[(p)->sclass])
+
+// sched_order에서의 위치. 작을수록 먼저 실행됨
+static int
+class_rank(struct sched_class *cls)
+{
+  int i;
+
+  for (i = 0; sched_order[i] != cls; i++)
+    ;
+  return i;
+}
+
+// 깨어난 p가 자신의 CPU에서 실행 중인 프로세스보다 먼저 실행되어야 한다면
+// 그 CPU에 재스케줄을 요청. 다른 CPU라면 IPI로 바로 알리고, 현재 CPU라면
+// trap()이 인터럽트나 시스템 콜에서 돌아가기 전에 양보한다.
+// ptable.lock을 잡고 있으므로 인터럽트는 꺼져 있음
+static void
+check_preempt(struct proc *p)
+{
+  struct cpu *c = &cpus[p->cpu];
+  struct proc *cur = c->proc;
+
+  if (cur == 0 || cur == p || c->rq.need_resched) // idle CPU는 스스로 큐를 확인함
+    return;
+  if (SCLASS(p) == SCLASS(cur) ? !SCLASS(p)->preempt(p, cur)
+                               : class_rank(SCLASS(p)) > class_rank(SCLASS(cur)))
+    return;
+  c->rq.need_resched = 1;
+  if (c != mycpu())
+    lapicipi(c->apicid, T_IRQ0 + IRQ_RESCHED);
+}
+
+// proc을 proc->cpu의 run queue에 넣음. proc->state는 RUNNABLE이어야 함
+static void
+enqueue_proc(struct proc *p, int flags)
+{
+  struct runq *rq = &cpus[p->cpu].rq;
+
+  if (!(flags & ENQ_MOVE))
+    p->rq_tsc = rdtsc64();
+  SCLASS(p)->enqueue(rq, p, flags);
+  rq->nrunnable++;
+  if (flags & ENQ_WAKEUP)
+    check_preempt(p);
+}
+
+static void
+dequeue_proc(struct proc *p)
+{
+  struct runq *rq = &cpus[p->cpu].rq;
+
+  if (p->state != RUNNABLE)
+    panic("dequeue_proc");
+  SCLASS(p)->dequeue(rq, p);
+  rq->nrunnable--;
+}
+
+// c의 run queue에서 다음에 실행할 프로세스를 꺼냄.
+// steal이 0이 아니면 다른 CPU의 큐이므로 CPU에 고정된 클래스는 건너뜀
+static struct proc*
+pick_next_proc(struct cpu *c, int steal)
+{
+  struct proc *p;
+
+  for (int i = 0; i < NELEM(sched_order); i++) {
+    if (steal && sched_order[i]->pinned)
+      continue;
+    if ((p = sched_order[i]->pick_next(&c->rq)) != 0) {
+      dequeue_proc(p);
+      return p;
     }
-    if (best_pri != MAXPRIOR) // 해당 큐에서 발견됐다면 리턴
-      break;
   }
-  if (best_pri == MAXPRIOR)
-    best_pri = 0;
-  
-  return best_pri;
+  return 0;
 }
 
-void
-update_priority(struct proc *proc, int priority)
+// c를 제외하고 실행 대기 중인 프로세스가 가장 많은 CPU. 모두 비어있다면 0
+static struct cpu*
+busiest_cpu(struct cpu *c)
+{
+  struct cpu *peer, *busiest = 0;
+
+  for (peer = cpus; peer < &cpus[ncpu]; peer++) {
+    if (peer == c || peer->rq.nrunnable == 0)
+      continue;
+    if (busiest == 0 || peer->rq.nrunnable > busiest->rq.nrunnable)
+      busiest = peer;
+  }
+  return busiest;
+}
+
+// 새 프로세스를 넣을 가장 한가한 CPU의 번호. 같으면 현재 CPU 우선.
+// 인터럽트가 꺼진 상태에서 호출해야 함
+static int
+idlest_cpu(void)
 {
+  struct cpu *c, *best;
+  int load, bestload;
+
+  best = mycpu();
+  bestload = best->rq.nrunnable + (best->proc != 0);
+  for (c = cpus; c < &cpus[ncpu]; c++) {
+    load = c->rq.nrunnable + (c->proc != 0);
+    if (load < bestload) {
+      best = c;
+      bestload = load;
+    }
+  }
+  return best - cpus;
+}
+
+// proc의 priority를 바꾸고 우선순위 클래스에서 실행 대기 중이라면 해당 큐로 옮김.
+// ptable.lock 필요.
+static void
+set_priority(struct proc *proc, int priority)
+{
+  aged_priority(proc); // 지난 주기의 priority_tick을 먼저 정리
 #ifdef DEBUGQ
   cprintf("update pid: %d, prior: %d, queue: ", proc->pid, priority);
-  print_run_queue(proc->priority/4);
+  print_run_queue(&cpus[proc->cpu].rq, proc->priority/4);
 #endif
-  pull_runqueue(proc);
-  proc->priority = priority;  
-  put_runqueue(proc);
+  if (proc->state == RUNNABLE && proc->sclass == SCHED_PRIO) {
+    dequeue_proc(proc);
+    proc->priority = priority;
+    enqueue_proc(proc, ENQ_MOVE);
+  } else
+    proc->priority = priority;
 #ifdef DEBUGQ
   cprintf("update result:\n");
   print_run_queues();
 #endif
 }
 
+void
+update_priority(struct proc *proc, int priority)
+{
+  acquire(&ptable.lock);
+  set_priority(proc, priority);
+  release(&ptable.lock);
+}
+
+// 현재 프로세스의 스케줄링 클래스를 바꿈. 실행 중이므로 run queue에는 없음
+int
+set_sched_class(int sclass)
+{
+  struct proc *p = myproc();
+
+  if (sclass < 0 || sclass >= NELEM(sched_classes))
+    return -1;
+  if (sclass == SCHED_EDF) // 주기와 예산이 필요하므로 set_rt_params로만 들어감
+    return -1;
+  acquire(&ptable.lock);
+  if (p->sclass == SCHED_EDF)
+    rt_util[p->cpu] -= RT_UTIL(p->rt_budget, p->rt_period);
+  if (sclass == SCHED_FAIR && p->sclass != SCHED_FAIR)
+    p->vruntime = cpus[p->cpu].rq.min_vruntime; // 현재 큐의 프로세스들과 같은 위치에서 시작
+  p->sclass = sclass;
+  release(&ptable.lock);
+  return 0;
+}
+
+// 현재 프로세스를 실시간 클래스로 바꿈. period tick마다 budget tick을 보장받는다.
+// 각 CPU의 실시간 사용률 합이 RTMAXUTIL을 넘지 않는 CPU 중 가장 여유 있는 곳에
+// 고정하며, 그런 CPU가 없거나 period가 RTMAXPERIOD보다 길면 -1 (기존 설정은 유지)
+int
+set_rt_params(uint period, uint budget)
+{
+  struct proc *p = myproc();
+  uint util;
+  int i, best = -1;
+
+  if (budget == 0 || budget > period || period > RTMAXPERIOD)
+    return -1;
+  util = RT_UTIL(budget, period);
+  acquire(&ptable.lock);
+  if (p->sclass == SCHED_EDF) // 설정을 바꾸는 경우 자신의 몫은 빼고 계산
+    rt_util[p->cpu] -= RT_UTIL(p->rt_budget, p->rt_period);
+  for (i = 0; i < ncpu; i++)
+    if (rt_util[i] + util <= RTMAXUTIL && (best < 0 || rt_util[i] < rt_util[best]))
+      best = i;
+  if (best < 0) {
+    if (p->sclass == SCHED_EDF)
+      rt_util[p->cpu] += RT_UTIL(p->rt_budget, p->rt_period);
+    release(&ptable.lock);
+    return -1;
+  }
+  rt_util[best] += util;
+  p->cpu = best; // 다음 yield부터 해당 CPU의 큐에 들어감
+  p->sclass = SCHED_EDF;
+  p->rt_period = period;
+  p->rt_budget = budget;
+  p->rt_deadline = ticks + period;
+  p->rt_used = 0;
+  release(&ptable.lock);
+  return 0;
+}
+
+// 실시간 프로세스가 이번 주기의 예산을 다 썼다면 다음 주기가 시작될 때까지 잠듦.
+// 사용자 모드에서 온 타이머 인터럽트에서 호출
+void
+rt_throttle(void)
+{
+  struct proc *p = myproc();
+
+  if (p->sclass != SCHED_EDF || p->rt_used < p->rt_budget)
+    return;
+  acquire(&ptable.lock);
+  // 새 주기는 이번 마감에 시작
+  p->rt_release = p->rt_deadline;
+  p->rt_deadline += p->rt_period;
+  p->rt_used = 0;
+  if (rt_nthrottled++ == 0 || (int)(p->rt_release - rt_next_release) < 0)
+    rt_next_release = p->rt_release;
+  sleep(&p->rt_release, &ptable.lock);
+  release(&ptable.lock);
+}
+
+// 주기가 시작된 실시간 프로세스를 깨움. CPU 0의 타이머 인터럽트에서 매 tick 호출하며,
+// 깨울 프로세스가 없는 tick에는 잠금 없이 바로 돌아감
+void
+rt_release_tick(uint now)
+{
+  struct proc *p;
+  int n = 0;
+
+  if (rt_nthrottled == 0 || (int)(now - rt_next_release) < 0)
+    return;
+  acquire(&ptable.lock);
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++) {
+    if (p->state != SLEEPING || p->chan != &p->rt_release)
+      continue;
+    if ((int)(now - p->rt_release) >= 0)
+      wakeproc(p, ENQ_WAKEUP);
+    else if (n++ == 0 || (int)(p->rt_release - rt_next_release) < 0)
+      rt_next_release = p->rt_release;
+  }
+  rt_nthrottled = n; // kill로 먼저 깨어난 프로세스도 여기서 정리됨
+  release(&ptable.lock);
+}
+
+// 현재 CPU에 재스케줄 요청(need_resched)이 있는가
+int
+resched_pending(void)
+{
+  int r;
+
+  pushcli();
+  r = mycpu()->rq.need_resched;
+  popcli();
+  return r;
+}
+
+// 실행 중인 프로세스의 사용 시간을 계산. 각 CPU의 타이머 인터럽트에서 자신이
+// 실행 중인 프로세스에 대해 호출. 0이 아니면 CPU를 양보해야 함
+int
+sched_tick(struct proc *p)
+{
+  p->proc_tick++;
+  p->cpu_used++;
+  return SCLASS(p)->tick(p);
+}
+
 //PAGEBREAK: 32
 // Set up first user process.
 void
@@ -276,7 +896,11 @@ userinit(void)
 
   p->priority = MAXPRIOR; // idle process(init process)는 priority 99(최대 값)
   p->state = RUNNABLE;
-  put_runqueue(p);
+  p->cpu = 0;
+  p->epoch = priority_epoch;
+  p->sclass = SCHED_DEFAULT;
+  p->vruntime = 0;
+  enqueue_proc(p, 0);
 
   release(&ptable.lock);
 }
@@ -308,7 +932,7 @@ growproc(int n)
 int
 fork(void)
 {
-  int i, pid;
+  int i, pid, cpu;
   struct proc *np;
   struct proc *curproc = myproc();
 
@@ -340,13 +964,20 @@ fork(void)
 
   pid = np->pid;
 
+  pushcli();
+  cpu = idlest_cpu(); // CPU들을 훑는 동안 ptable.lock을 잡지 않음
+  popcli();
+
   acquire(&ptable.lock);
 
   np->state = RUNNABLE;
-  np->priority = get_best_priority(np); // 현재 run_queue에서 관리하는 프로세스중 가장 작은 priority 값 부여
-  if (np->pid == 1 || np->pid == 2) // 만약 idle 프로세스라면 최대 prior 값 부여
-    np->priority = MAXPRIOR;
-  put_runqueue(np); // run_queue에 등록
+  np->epoch = priority_epoch;
+  np->sclass = curproc->sclass; // 스케줄링 클래스는 부모를 따름
+  if (np->sclass == SCHED_EDF) // 실시간 사용률은 승인된 프로세스만의 몫
+    np->sclass = SCHED_DEFAULT;
+  np->vruntime = curproc->vruntime;
+  np->cpu = cpu; // 가장 한가한 CPU에 배정
+  enqueue_proc(np, ENQ_HEAD | ENQ_WAKEUP); // run_queue에 등록. 가장 높은 priority 부여
 
   release(&ptable.lock);
 
@@ -381,7 +1012,10 @@ exit(void)
 
   acquire(&ptable.lock);
 
-  pull_runqueue(curproc); // 종료시 runqueue에서 빼냄
+  if (curproc->sclass == SCHED_EDF) // 승인된 실시간 사용률 반환
+    rt_util[curproc->cpu] -= RT_UTIL(curproc->rt_budget, curproc->rt_period);
+  curproc->sclass = SCHED_DEFAULT;
+
   // Parent might be sleeping in wait().
   wakeup1(curproc->parent);
 
@@ -430,11 +1064,16 @@ wait(void)
 
         p->priority = MAXPRIOR; // 종료된 프로세스는 혹시 모르니 최대값
         p->proc_tick = 0;
-        p->priority_tick = 0;
-        p->updated = 0; // 값 초기화
+        p->priority_tick = 0; // 값 초기화
         p->cpu_used = 0;
         p->timer = 0;
 
+        // 자식과 그 자손들의 히스토그램을 부모에게 더함
+        for (int i = 0; i < NSCHEDHIST; i++) {
+          curproc->clat_hist[i] += p->lat_hist[i] + p->clat_hist[i];
+          curproc->crun_hist[i] += p->run_hist[i] + p->crun_hist[i];
+        }
+
         p->state = UNUSED;
         release(&ptable.lock);
         return pid;
@@ -453,62 +1092,63 @@ wait(void)
 }
 
 // 스케줄 될 프로세스를 얻는 함수
+// 앞선 스케줄링 클래스부터 from의 run queue에서 다음 프로세스를 꺼냄.
+// from은 scheduler가 잠금 없이 고른 자신 또는 가장 바쁜 CPU. 그 사이 비었다면 0
 struct proc*
-ssu_schedule()
-{
-  struct run_queue *q;
-  int best_pri = MAXPRIOR + 1; // 가장 높은 우선순위. MAXPRIOR도 스케줄 되야 하므로
-  int best_tick = TIMEQUANTUM + 1; // 가장 높은 TQ
-  struct proc *best_proc = 0; // 가장 높은 우선순위 proc
-
-  for (int i=0; i < MAXRUNQ; i++) { // 전체 RUNQ 탐색
-    for (q = run_queues[i]; q != 0; q = q->next) { // 연결 리스트 탐색
-      if (q->rproc->state == RUNNABLE && q->rproc->priority <= best_pri) { // RUNNABLE이고 이전 프로세스보다 우선순위가 높을경우
-        if (q->rproc->priority == best_pri && q->rproc->cpu_used >= best_tick) // 같을 경우는 proc_tick이 짧은 경우
-          continue;
-        best_proc = q->rproc;
-        best_pri = best_proc->priority;
-        best_tick = best_proc->cpu_used;
-      }
-    }
-    if (best_proc) // 해당 큐에서 발견됐다면 리턴
-      break;
-  }
-
-  return best_proc;
+ssu_schedule(struct cpu *c, struct cpu *from)
+{
+  return pick_next_proc(from, from != c);
 }
 
 // 우선순위 증가 함수
+// aging 주기만 넘기고, 실제 재계산은 각 프로세스가 다음에 큐에 들어가거나
+// 스케줄러에 선택되거나 tick을 사용할 때 aged_priority로 한다.
+// 타이머 인터럽트에서 프로세스 수와 상관없이 상수 시간에 끝남
 void
 ssu_update_priority()
 {
-  struct run_queue *q;
-  struct run_queue *nq;
-  struct proc *p;
-  int new_priority;
-
 #ifdef DEBUGQ
   cprintf("ssu_update()\n");
 #endif
-  for (int i=0; i < MAXRUNQ; i++) { // 전체 RUNQ 탐색
-    for (q = run_queues[i]; q != 0; q = nq) {
-      if (q->rproc->updated) // 이미 업데이트 됐을 경우
+  priority_epoch++;
+}
+
+// cycles가 속한 log2 칸을 하나 증가. 마지막 칸을 넘으면 마지막 칸
+static void
+hist_add(uint *hist, uint64 cycles)
+{
+  uint hi = cycles >> 32, lo = cycles;
+  uint i;
+
+  i = hi ? 32 + bsr(hi) : (lo ? bsr(lo) : 0);
+  if (i >= NSCHEDHIST)
+    i = NSCHEDHIST - 1;
+  hist[i]++;
+}
+
+// pid 프로세스의 스케줄링 히스토그램을 lat, run(각각 NSCHEDHIST칸)에 복사.
+// pid가 0이면 자신, 음수면 자신이 wait로 회수한 자손들의 합. 없는 pid면 -1
+int
+getschedstat(int pid, uint *lat, uint *run)
+{
+  struct proc *p, *curproc = myproc();
+
+  acquire(&ptable.lock);
+  if (pid <= 0)
+    p = curproc;
+  else {
+    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+      if (p->pid == pid && p->state != UNUSED)
         break;
-      new_priority = q->rproc->priority + (q->rproc->priority_tick / 10); // 우선순위 값 설정
-      if (q->rproc->pid == 1 || q->rproc->pid == 2 || new_priority > 99) // IDLEPROC은 고정
-        new_priority = 99;
-
-      nq = q->next;
-      p = q->rproc;
-      update_priority(q->rproc, new_priority);
-      p->updated = 1; // 업데이트 됐음을 알림
-      p->priority_tick = 0;
+    if (p == &ptable.proc[NPROC]) {
+      release(&ptable.lock);
+      return -1;
     }
   }
-  for (int i=0; i < MAXRUNQ; i++) { // 다시 모든 run_queue에 대해 updated 값을 0으로 만들어줌
-    for (q = run_queues[i]; q != 0; q = q->next)
-      q->rproc->updated = 0;
-  }
+  memmove(lat, pid < 0 ? p->clat_hist : p->lat_hist, sizeof(p->lat_hist));
+  memmove(run, pid < 0 ? p->crun_hist : p->run_hist, sizeof(p->run_hist));
+  release(&ptable.lock);
+  return 0;
 }
 
 //PAGEBREAK: 42
@@ -524,25 +1164,38 @@ scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  struct cpu *from;
+  uint64 start;
   c->proc = 0;
   
   for(;;){
     // Enable interrupts on this processor.
     sti();
 
-    // Loop over process table looking for process to run.
+    // 잠금 없이 꺼낼 run queue를 먼저 고름(자신, 비었으면 가장 바쁜 CPU). idle CPU들이
+    // ptable.lock을 계속 잡지 않고, CPU들을 훑는 동안에도 ptable.lock을 잡지 않음
+    if(c->rq.nrunnable)
+      from = c;
+    else if((from = busiest_cpu(c)) == 0)
+      continue;
+
     acquire(&ptable.lock);
 
     // ssu_scheduling으로 변경
-    if((p = ssu_schedule())) {
+    if((p = ssu_schedule(c, from))) {
       // Switch to chosen process.  It is the process's job
       // to release ptable.lock and then reacquire it
       // before jumping back to us.
+      p->cpu = c - cpus;
       c->proc = p;
+      c->rq.need_resched = 0;
+      start = rdtsc64();
+      hist_add(p->lat_hist, start - p->rq_tsc);
       switchuvm(p);
       p->state = RUNNING;
       swtch(&(c->scheduler), p->context);
       switchkvm();
+      hist_add(p->run_hist, rdtsc64() - start);
 
 #ifdef DEBUG
       cprintf("PID : %d, NAME : %s, priority : %d, proc_tick : %d ticks, total_cpu_usage : %d ticks\n", p->pid, p->name, p->priority, p->proc_tick, p->cpu_used);
@@ -592,6 +1245,7 @@ yield(void)
 {
   acquire(&ptable.lock);  //DOC: yieldlock
   myproc()->state = RUNNABLE;
+  enqueue_proc(myproc(), 0); // Time Quantum을 다 쓴 프로세스는 큐의 뒤로
   sched();
   release(&ptable.lock);
 }
@@ -617,6 +1271,44 @@ forkret(void)
   // Return to "caller", actually trapret (see allocproc).
 }
 
+// 잠든 프로세스를 chan으로 나눈 해시 테이블. 버킷마다 sq_next/sq_prev로 연결하며
+// wakeup은 chan이 속한 버킷만 확인한다. ptable.lock으로 보호
+#define SLEEPQ_SHIFT 6
+#define NSLEEPQ      (1 << SLEEPQ_SHIFT)
+
+static struct proc *sleepq[NSLEEPQ];
+
+// 곱셈 해시(2^32 / 황금비)의 상위 비트. 정렬된 주소의 하위 비트가 모두 같아도 고르게 나뉨
+static struct proc**
+sleepq_bucket(void *chan)
+{
+  return &sleepq[((uint)chan * 2654435761U) >> (32 - SLEEPQ_SHIFT)];
+}
+
+static void
+sleepq_insert(struct proc *p)
+{
+  struct proc **b = sleepq_bucket(p->chan);
+
+  p->sq_prev = 0;
+  p->sq_next = *b;
+  if (*b)
+    (*b)->sq_prev = p;
+  *b = p;
+}
+
+static void
+sleepq_remove(struct proc *p)
+{
+  if (p->sq_prev)
+    p->sq_prev->sq_next = p->sq_next;
+  else
+    *sleepq_bucket(p->chan) = p->sq_next;
+  if (p->sq_next)
+    p->sq_next->sq_prev = p->sq_prev;
+  p->sq_next = p->sq_prev = 0;
+}
+
 // Atomically release lock and sleep on chan.
 // Reacquires lock when awakened.
 void
@@ -643,6 +1335,7 @@ sleep(void *chan, struct spinlock *lk)
   // Go to sleep.
   p->chan = chan;
   p->state = SLEEPING;
+  sleepq_insert(p);
 
   sched();
 
@@ -656,20 +1349,29 @@ sleep(void *chan, struct spinlock *lk)
   }
 }
 
+// 잠든 프로세스를 깨워 run queue에 넣음. ptable.lock 필요
+static void
+wakeproc(struct proc *p, int flags)
+{
+  sleepq_remove(p);
+  p->state = RUNNABLE;
+  enqueue_proc(p, flags);
+}
+
 //PAGEBREAK!
 // Wake up all processes sleeping on chan.
 // The ptable lock must be held.
+// chan의 버킷에 있는 프로세스만 확인하므로 NPROC과 무관
 static void
 wakeup1(void *chan)
 {
-  struct proc *p;
+  struct proc *p, *next;
 
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == SLEEPING && p->chan == chan){
-      if(p->pid != 1 && p->pid != 2) // IDLEPROC이 아니라면
-        p->priority = get_best_priority(p); // 현재 run_queue에서 관리하는 프로세스중 가장 작은 priority 값 부여
-      p->state = RUNNABLE;
-    }
+  for(p = *sleepq_bucket(chan); p; p = next){
+    next = p->sq_next;
+    if(p->chan == chan)
+      wakeproc(p, ENQ_HEAD | ENQ_WAKEUP); // 가장 높은 priority 부여
+  }
 }
 
 // Wake up all processes sleeping on chan.
@@ -695,7 +1397,7 @@ kill(int pid)
       p->killed = 1;
       // Wake process from sleep if necessary.
       if(p->state == SLEEPING)
-        p->state = RUNNABLE;
+        wakeproc(p, ENQ_HEAD);
       release(&ptable.lock);
       return 0;
     }
@@ -723,7 +1425,12 @@ procdump(void)
   struct proc *p;
   char *state;
   uint pc[10];
+  uint tmax = 0;
 
+  for(i = 0; i < ncpu; i++)
+    if(cpus[i].timer_max > tmax)
+      tmax = cpus[i].timer_max;
+  cprintf("timer interrupt worst case: %d cycles\n", tmax);
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
     if(p->state == UNUSED)
       continue;
@@ -1,3 +1,33 @@
+// CPU별 run queue
+// 비트맵의 i번째 비트가 1이면 head[i]에 실행 대기 중인 프로세스가 있음
+struct runq {
+  struct proc *head[MAXRUNQ];      // 25개의 run queue
+  struct proc *tail[MAXRUNQ];      // 각 run queue의 tail. O(1) 삽입용
+  uint bitmap;
+  struct proc *fair_root;          // fair 클래스: vruntime 순서의 AVL 트리
+  uint min_vruntime;               // fair 클래스: 큐의 최소 vruntime. 단조 증가
+  struct proc *edf_head;           // 실시간 클래스: 마감 시간 순서의 리스트
+  volatile int nrunnable;          // 큐에 있는 프로세스 수
+  volatile int need_resched;       // 실행 중인 프로세스가 바로 양보해야 함
+};
+
+// 스케줄링 클래스. 각 CPU의 run queue 안에서 클래스마다 자신의 자료구조로
+// 프로세스를 관리한다. 클래스 사이에서는 proc.c의 sched_order 앞쪽이 먼저 실행됨
+struct sched_class {
+  char *name;
+  void (*enqueue)(struct runq *rq, struct proc *p, int flags); // 실행 대기로 넣음
+  void (*dequeue)(struct runq *rq, struct proc *p);            // 실행 대기에서 뺌
+  struct proc *(*pick_next)(struct runq *rq);  // 다음에 실행할 프로세스. 큐에서 빼지는 않음
+  int (*tick)(struct proc *p);                 // 실행 중 매 tick. 0이 아니면 CPU 양보
+  int (*preempt)(struct proc *p, struct proc *cur); // 깨어난 p가 같은 클래스의 cur를 밀어내는가
+  int pinned;                                  // 다른 CPU가 가져갈 수 없음
+};
+
+// enqueue flags
+#define ENQ_HEAD    1   // 같은 우선순위의 맨 앞에 넣음
+#define ENQ_WAKEUP  2   // 새로 생성되거나 깨어남
+#define ENQ_MOVE    4   // 이미 실행 대기 중인 프로세스를 옮김. 대기 시작 시각 유지
+
 // Per-CPU state
 struct cpu {
   uchar apicid;                // Local APIC ID
@@ -8,6 +38,8 @@ struct cpu {
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
   struct proc *proc;           // The process running on this cpu or null
+  struct runq rq;              // 이 CPU의 run queue
+  uint timer_max;              // 타이머 인터럽트 처리에 걸린 최대 cycle 수. ^P로 확인
 };
 
 extern struct cpu cpus[NCPU];
@@ -53,18 +85,31 @@ struct proc {
   int priority;               // 스케쥴 우선순위. 낮을 수록 높은 우선순위. 0~99 사이 값. idle process = 99
   uint proc_tick;             // 프로세스가 스케줄링 된 이후 다시 스케줄링 되기 전까지 CPU를 사용한 시간(tick)
   uint priority_tick;         // priority 계산을 위한 시간 저장
-  int updated;                // 업데이트 됐는지 여부 파악
+  uint epoch;                 // priority를 마지막으로 재계산한 aging 주기
   uint cpu_used;              // 프로세스가 생성된 이후 CPU를 사용한 총 합 시간(tick)
 
   uint timer;                 // 임종 시간. 0이면 설정 x.
-};
-
-// run_queue
-struct run_queue {
-  int is_used;  // 사용 중인지
+  int cpu;                    // 마지막으로 실행된 CPU. 해당 CPU의 run queue를 사용
+  int sclass;                 // 스케줄링 클래스 (SCHED_*)
+  uint vruntime;              // fair 클래스: 실행한 시간(tick)
+  struct proc *vleft;         // fair 클래스: AVL 트리의 왼쪽 자식
+  struct proc *vright;        // fair 클래스: AVL 트리의 오른쪽 자식
+  int vheight;                // fair 클래스: AVL 트리에서의 높이
+  uint rt_period;             // 실시간 클래스: 주기(tick)
+  uint rt_budget;             // 실시간 클래스: 주기마다 실행할 수 있는 시간(tick)
+  uint rt_deadline;           // 실시간 클래스: 현재 주기의 마감 시각(tick)
+  uint rt_used;               // 실시간 클래스: 현재 주기에 사용한 시간(tick)
+  uint rt_release;            // 실시간 클래스: 예산 소진 시 다음 주기 시작 시각
+  struct proc *rq_next;       // run queue의 다음 프로세스
+  struct proc *rq_prev;       // run queue의 이전 프로세스
+  struct proc *sq_next;       // 같은 sleep 해시 버킷의 다음 프로세스
+  struct proc *sq_prev;       // 같은 sleep 해시 버킷의 이전 프로세스
 
-  struct proc *rproc; // process
-  struct run_queue *next; // 다음 element
+  uint64 rq_tsc;                    // 실행 대기를 시작한 시각(rdtsc64)
+  uint lat_hist[NSCHEDHIST];        // 실행 대기에서 실행까지 걸린 cycle의 log2 히스토그램
+  uint run_hist[NSCHEDHIST];        // 한 번 실행된 cycle의 log2 히스토그램
+  uint clat_hist[NSCHEDHIST];       // wait로 회수한 자손들의 lat_hist 합
+  uint crun_hist[NSCHEDHIST];       // wait로 회수한 자손들의 run_hist 합
 };
 
 // Process memory is laid out contiguously, low addresses first:
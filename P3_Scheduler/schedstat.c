@@ -0,0 +1,84 @@
+// Print a process's scheduling histograms.
+//   schedstat pid         a live process
+//   schedstat cmd args    run cmd, then print it and its descendants
+// Each row is a power-of-two range of TSC cycles; the last row
+// also counts everything longer. "wait" counts how
+// long the process sat runnable before it ran, "run" how long each
+// run lasted before it gave up the cpu.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+
+uint lat[NSCHEDHIST];
+uint run[NSCHEDHIST];
+
+// Bucket (log2 of its lower bound) holding the p-th percentile.
+int
+percentile(uint *hist, int p)
+{
+  uint total, seen;
+  int i;
+
+  total = 0;
+  for(i = 0; i < NSCHEDHIST; i++)
+    total += hist[i];
+  seen = 0;
+  for(i = 0; i < NSCHEDHIST; i++){
+    seen += hist[i];
+    if(seen*100 >= total*p)
+      return i;
+  }
+  return 0;
+}
+
+void
+print(char *what)
+{
+  int i;
+
+  printf(1, "%s\n", what);
+  printf(1, "cycles >=\twait\trun\n");
+  for(i = 0; i < NSCHEDHIST; i++)
+    if(lat[i] || run[i])
+      printf(1, "2^%d%s\t\t%d\t%d\n", i, i == NSCHEDHIST-1 ? "+" : "", lat[i], run[i]);
+  printf(1, "wait p50 2^%d p99 2^%d, run p50 2^%d p99 2^%d\n",
+         percentile(lat, 50), percentile(lat, 99),
+         percentile(run, 50), percentile(run, 99));
+}
+
+int
+main(int argc, char *argv[])
+{
+  int pid;
+
+  if(argc < 2){
+    printf(2, "usage: schedstat pid | schedstat cmd [args...]\n");
+    exit();
+  }
+
+  if(argv[1][0] >= '0' && argv[1][0] <= '9'){
+    pid = atoi(argv[1]);
+    if(getschedstat(pid, lat, run) < 0){
+      printf(2, "schedstat: no process %d\n", pid);
+      exit();
+    }
+    print(argv[1]);
+    exit();
+  }
+
+  if((pid = fork()) < 0){
+    printf(2, "schedstat: fork failed\n");
+    exit();
+  }
+  if(pid == 0){
+    exec(argv[1], argv+1);
+    printf(2, "schedstat: exec %s failed\n", argv[1]);
+    exit();
+  }
+  wait();
+  getschedstat(-1, lat, run);
+  print(argv[1]);
+  exit();
+}
@@ -1,8 +1,14 @@
 #include "types.h"
 #include "stat.h"
 #include "user.h"
+#include "param.h"
 
 #define PNUM 3
+#define PICKTICKS 200 // pick 측정 시간(tick)
+#define FAIRTICKS 300 // fair 측정 시간(tick)
+#define RTPERIOD 10   // rt 실험의 주기(tick)
+#define RTBUDGET 2    // rt 실험의 주기당 예산(tick)
+#define RTROUNDS 30   // rt 실험에서 반복할 주기 수
 
 // set_sche_info 실험 데이터
 // (prior, timer)
@@ -29,12 +35,144 @@ void scheduler_func(void)
     if (!isChild)
         for (int i=0; i<PNUM; i++)
             wait();
-    
+
     printf(1, "end of scheduler_test\n");
 }
 
-int main(void)
+// 스케줄 결정 비용 측정
+// 프로세스 테이블이 찰 때까지(최대 NPROC-1개) spinner를 만들어 run queue를 채운 뒤
+// 부모와 자식 하나가 pipe로 토큰을 주고받는다. 왕복 한 번마다 두 번의 pick이 일어나므로
+// PICKTICKS 동안의 왕복 횟수로 pick 한 번에 걸리는 시간을 구한다.
+void pick_func(void)
+{
+    int spinners[NPROC];
+    int nspin = 0;
+    int ping[2], pong[2];
+    int partner, rounds = 0;
+    uint start;
+    char token = 'x';
+
+    if (pipe(ping) < 0 || pipe(pong) < 0) {
+        printf(1, "pick: pipe failed\n");
+        return;
+    }
+    if ((partner = fork()) == 0) { // 토큰을 되돌려주는 자식
+        while (read(ping[0], &token, 1) == 1)
+            write(pong[1], &token, 1);
+        exit();
+    }
+
+    while (nspin < NPROC - 1) { // fork가 실패할 때까지 spinner 생성
+        if ((spinners[nspin] = fork()) == 0)
+            for (;;) {};
+        if (spinners[nspin] < 0)
+            break;
+        nspin++;
+    }
+
+    printf(1, "start pick test: %d spinners\n", nspin);
+    start = uptime();
+    while (uptime() - start < PICKTICKS) {
+        write(ping[1], &token, 1);
+        read(pong[0], &token, 1);
+        rounds++;
+    }
+    if (rounds == 0) // 0으로 나누지 않도록
+        rounds = 1;
+    // 1 tick = 10ms
+    printf(1, "%d picks in %d ticks, %d us per pick\n",
+        rounds * 2, PICKTICKS, PICKTICKS * 10000 / (rounds * 2));
+
+    for (int i=0; i<nspin; i++)
+        kill(spinners[i]);
+    kill(partner);
+    for (int i=0; i<nspin+1; i++)
+        wait();
+    printf(1, "end of pick test\n");
+}
+
+// fair 클래스 실험
+// PNUM개의 자식을 fair 클래스로 바꿔 FAIRTICKS 동안 돌리고 각자 반복 횟수를 출력.
+// 자식마다 다른 priority를 줘도 횟수가 비슷하게 나와야 함
+void fair_func(void)
+{
+    uint end = uptime() + FAIRTICKS;
+    int cnt;
+
+    printf(1, "start fair test\n");
+    for (int i=0; i<PNUM; i++) {
+        if (fork() == 0) {
+            set_sche_info(sched_test_map[i][0], 0);
+            if (set_sche_class(SCHED_FAIR) < 0) {
+                printf(1, "set_sche_class failed\n");
+                exit();
+            }
+            for (cnt = 0; uptime() < end; cnt++) {};
+            printf(1, "child %d (priority %d): %d loops\n", i, sched_test_map[i][0], cnt);
+            exit();
+        }
+    }
+    for (int i=0; i<PNUM; i++)
+        wait();
+    printf(1, "end of fair test\n");
+}
+
+// 실시간 클래스 실험
+// 가장 높은 priority의 spinner들이 CPU를 차지한 상태에서 실시간 프로세스가
+// RTPERIOD마다 깨어나 일하는 제어 루프를 흉내낸다. 깨어날 시각보다 늦게 실행된
+// 최대 시간(tick)을 출력. 선점이 제대로 되면 TIMEQUANTUM과 무관하게 1 tick 이내
+void rt_func(void)
+{
+    int spinners[PNUM];
+    int pid, late, maxlate = 0;
+    uint next;
+
+    for (int i=0; i<PNUM; i++) {
+        if ((spinners[i] = fork()) == 0) {
+            set_sche_info(0, 0);
+            for (;;) {};
+        }
+    }
+
+    printf(1, "start rt test\n");
+    if ((pid = fork()) == 0) {
+        if (set_sche_rt(RTPERIOD, RTBUDGET) < 0) {
+            printf(1, "set_sche_rt failed\n");
+            exit();
+        }
+        for (int i=0; i<RTROUNDS; i++) {
+            next = uptime() + RTPERIOD;
+            sleep(RTPERIOD);
+            if ((late = uptime() - next) > maxlate)
+                maxlate = late;
+        }
+        printf(1, "%d periods, max wakeup lateness %d ticks\n", RTROUNDS, maxlate);
+        // 사용률이 RTMAXUTIL을 넘는 설정과 예산이 주기보다 긴 설정은 거절되어야 함.
+        // 주기가 아주 길어도 사용률 계산이 넘치지 않고 거절되어야 함
+        printf(1, "set_sche_rt(%d, %d) = %d\n", RTPERIOD, RTPERIOD, set_sche_rt(RTPERIOD, RTPERIOD));
+        printf(1, "set_sche_rt(%d, %d) = %d\n", RTPERIOD, RTPERIOD+1, set_sche_rt(RTPERIOD, RTPERIOD+1));
+        printf(1, "set_sche_rt(%d, %d) = %d\n", 5000000, 5000000, set_sche_rt(5000000, 5000000));
+        printf(1, "set_sche_rt(%d, %d) = %d\n", RTMAXPERIOD, RTMAXPERIOD, set_sche_rt(RTMAXPERIOD, RTMAXPERIOD));
+        exit();
+    }
+    wait();
+
+    for (int i=0; i<PNUM; i++)
+        kill(spinners[i]);
+    for (int i=0; i<PNUM; i++)
+        wait();
+    printf(1, "end of rt test\n");
+}
+
+int main(int argc, char *argv[])
 {
-    scheduler_func();
+    if (argc > 1 && strcmp(argv[1], "pick") == 0)
+        pick_func();
+    else if (argc > 1 && strcmp(argv[1], "fair") == 0)
+        fair_func();
+    else if (argc > 1 && strcmp(argv[1], "rt") == 0)
+        rt_func();
+    else
+        scheduler_func();
     exit();
-}
\ No newline at end of file
+}
@@ -104,6 +104,9 @@ extern int sys_wait(void);
 extern int sys_write(void);
 extern int sys_uptime(void);
 extern int sys_set_sche_info(void);
+extern int sys_set_sche_class(void);
+extern int sys_set_sche_rt(void);
+extern int sys_getschedstat(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -128,6 +131,9 @@ static int (*syscalls[])(void) = {
 [SYS_mkdir]   sys_mkdir,
 [SYS_close]   sys_close,
 [SYS_set_sche_info] sys_set_sche_info,
+[SYS_set_sche_class] sys_set_sche_class,
+[SYS_set_sche_rt] sys_set_sche_rt,
+[SYS_getschedstat] sys_getschedstat,
 };
 
 void
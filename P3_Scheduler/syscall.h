@@ -21,3 +21,6 @@
 #define SYS_mkdir  20
 #define SYS_close  21
 #define SYS_set_sche_info 22
+#define SYS_set_sche_class 23
+#define SYS_set_sche_rt 24
+#define SYS_getschedstat 25
@@ -102,9 +102,45 @@ sys_set_sche_info()
 
   if(argint(0, &prior) < 0 || argint(1, (int*)&timer) < 0)
     return -1;
+  if(prior < 0 || prior > MAXPRIOR) // 범위 밖의 priority는 run queue를 벗어남
+    return -1;
 
   update_priority(myproc(), prior);
   myproc()->timer = timer;
 
   return 0;
-}
\ No newline at end of file
+}
+
+int
+sys_set_sche_class(void)
+{
+  int sclass;
+
+  if(argint(0, &sclass) < 0)
+    return -1;
+  return set_sched_class(sclass);
+}
+int
+sys_set_sche_rt(void)
+{
+  int period, budget;
+
+  if(argint(0, &period) < 0 || argint(1, &budget) < 0)
+    return -1;
+  if(period <= 0 || budget <= 0)
+    return -1;
+  return set_rt_params(period, budget);
+}
+
+int
+sys_getschedstat(void)
+{
+  int pid;
+  uint *lat, *run;
+
+  if(argint(0, &pid) < 0 ||
+     argptr(1, (char**)&lat, NSCHEDHIST*sizeof(uint)) < 0 ||
+     argptr(2, (char**)&run, NSCHEDHIST*sizeof(uint)) < 0)
+    return -1;
+  return getschedstat(pid, lat, run);
+}
@@ -37,6 +37,9 @@ idtinit(void)
 void
 trap(struct trapframe *tf)
 {
+  uint tstart = rdtsc();
+  int resched = 0; // 스케줄링 클래스가 CPU 양보를 요청했는지
+
   if(tf->trapno == T_SYSCALL){
     if(myproc()->killed)
       exit();
@@ -44,29 +47,36 @@ trap(struct trapframe *tf)
     syscall();
     if(myproc()->killed)
       exit();
+    // 시스템 콜이 이 CPU의 프로세스보다 우선인 프로세스를 깨웠다면 바로 양보
+    if(resched_pending())
+      yield();
     return;
   }
 
   switch(tf->trapno){
   case T_IRQ0 + IRQ_TIMER:
+    // 프로세스가 running 상태일 경우 사용 자원 값 증가. 각 CPU가 자신의 프로세스를 계산
+    if(myproc() && myproc()->state == RUNNING)
+      resched = sched_tick(myproc());
+
     if(cpuid() == 0){
       acquire(&tickslock);
       ticks++;
 
-      // 프로세스가 running 상태일 경우 사용 자원 값 증가
-      if(myproc() && myproc()->state == RUNNING) {
-        myproc()->proc_tick++;
-        myproc()->priority_tick++;
-        myproc()->cpu_used++;
-
-        update_ticks++;
-      }
+      // CPU 0이 프로세스를 실행한 60 tick 마다 priority 재계산
+      if(myproc() && myproc()->state == RUNNING && ++update_ticks % (TIMEQUANTUM*2) == 0)
+        ssu_update_priority();
 
       wakeup(&ticks);
+      rt_release_tick(ticks); // 다음 주기가 시작된 실시간 프로세스를 깨움
       release(&tickslock);
     }
     lapiceoi();
     break;
+  case T_IRQ0 + IRQ_RESCHED:
+    // 다른 CPU가 이 CPU의 큐에 더 먼저 실행할 프로세스를 넣음. 아래에서 양보
+    lapiceoi();
+    break;
   case T_IRQ0 + IRQ_IDE:
     ideintr();
     lapiceoi();
@@ -111,20 +121,27 @@ trap(struct trapframe *tf)
   if(myproc() && myproc()->killed && (tf->cs&3) == DPL_USER)
     exit();
     
-  // 60 tick 마다 priority 재계산
-  if(tf->trapno == T_IRQ0+IRQ_TIMER && update_ticks != 0 && update_ticks % (TIMEQUANTUM*2) == 0)
-    ssu_update_priority();
-  
+  // 타이머 인터럽트 처리 시간 중 최댓값 기록. CPU마다 따로 두므로 잠금 없이 갱신.
+  // 인터럽트 게이트로 들어와 아직 인터럽트가 꺼져 있음
+  if(tf->trapno == T_IRQ0+IRQ_TIMER && (tstart = rdtsc() - tstart) > mycpu()->timer_max)
+    mycpu()->timer_max = tstart;
+
   // 지정 시간 경과시 프로세스 종료
   if (myproc() && myproc()->state == RUNNING &&
       tf->trapno == T_IRQ0+IRQ_TIMER && myproc()->timer != 0 && myproc()->timer <= myproc()->cpu_used)
     exit();
 
-  // Time Quantum(30 tick) 마다 스케줄링
+  // 실시간 프로세스가 이번 주기의 예산을 다 썼다면 다음 주기까지 대기
+  if(myproc() && myproc()->state == RUNNING &&
+     tf->trapno == T_IRQ0+IRQ_TIMER && (tf->cs&3) == DPL_USER)
+    rt_throttle();
+
+  // 스케줄링 클래스가 정한 시간(우선순위 클래스는 Time Quantum 30 tick)마다,
+  // 또는 이 CPU에 먼저 실행되어야 할 프로세스가 깨어났다면(인터럽트 종류와 무관) 스케줄링
   // Force process to give up CPU on clock tick.
   // If interrupts were on while locks held, would need to check nlock.
   if(myproc() && myproc()->state == RUNNING &&
-     tf->trapno == T_IRQ0+IRQ_TIMER && myproc()->proc_tick > 0 && myproc()->proc_tick % TIMEQUANTUM == 0)
+     ((tf->trapno == T_IRQ0+IRQ_TIMER && resched) || mycpu()->rq.need_resched))
     yield();
 
   // Check if the process has been killed since we yielded
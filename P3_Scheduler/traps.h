@@ -34,5 +34,6 @@
 #define IRQ_COM1         4
 #define IRQ_IDE         14
 #define IRQ_ERROR       19
+#define IRQ_RESCHED     20      // 다른 CPU의 재스케줄 요청 (IPI)
 #define IRQ_SPURIOUS    31
 
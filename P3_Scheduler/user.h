@@ -24,6 +24,9 @@ char* sbrk(int);
 int sleep(int);
 int uptime(void);
 int set_sche_info(int priority, uint timer);
+int set_sche_class(int sclass);
+int set_sche_rt(int period, int budget);
+int getschedstat(int pid, uint *lat, uint *run);
 
 // ulib.c
 int stat(const char*, struct stat*);
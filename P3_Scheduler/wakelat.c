@@ -0,0 +1,97 @@
+// Wake-to-run latency benchmark.
+// Keeps every cpu busy with low-priority spinners, then wakes a
+// sleeping reader NSAMPLE times by writing the current time-stamp
+// counter into a pipe. The reader subtracts it from its own
+// time-stamp counter once it runs, and reports percentiles in cycles.
+// Without wakeup preemption the tail is bounded by TIMEQUANTUM ticks.
+// Usage: wakelat [nspin]
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "x86.h"
+
+#define NSAMPLE  200
+#define NSPIN    4      // default number of spinners
+
+uint lat[NSAMPLE];
+
+// Insertion sort; NSAMPLE is small.
+void
+sort(uint *a, int n)
+{
+  int i, j;
+  uint v;
+
+  for(i = 1; i < n; i++){
+    v = a[i];
+    for(j = i; j > 0 && a[j-1] > v; j--)
+      a[j] = a[j-1];
+    a[j] = v;
+  }
+}
+
+void
+reader(int fd)
+{
+  uint ts;
+  int n;
+
+  for(n = 0; n < NSAMPLE; n++){
+    if(read(fd, &ts, sizeof(ts)) != sizeof(ts))
+      break;
+    lat[n] = rdtsc() - ts;
+  }
+  if(n == 0)
+    exit();
+  sort(lat, n);
+  printf(1, "wakelat: %d wakeups, cycles p50 %d p90 %d p99 %d max %d\n",
+         n, lat[n*50/100], lat[n*90/100], lat[n*99/100], lat[n-1]);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int spinners[NPROC];
+  int fd[2];
+  int i, nspin;
+  uint ts;
+
+  nspin = argc > 1 ? atoi(argv[1]) : NSPIN;
+  if(nspin > NPROC - 4)
+    nspin = NPROC - 4;
+
+  for(i = 0; i < nspin; i++){
+    if((spinners[i] = fork()) == 0){
+      set_sche_info(MAXPRIOR - 1, 0);
+      for(;;)
+        ;
+    }
+  }
+
+  if(pipe(fd) < 0){
+    printf(1, "wakelat: pipe failed\n");
+    exit();
+  }
+  if(fork() == 0){
+    close(fd[1]);
+    reader(fd[0]);
+    exit();
+  }
+  close(fd[0]);
+
+  for(i = 0; i < NSAMPLE; i++){
+    sleep(1);   // let the reader block in read() again
+    ts = rdtsc();
+    write(fd[1], &ts, sizeof(ts));
+  }
+  close(fd[1]);
+  wait();
+
+  for(i = 0; i < nspin; i++)
+    kill(spinners[i]);
+  for(i = 0; i < nspin; i++)
+    wait();
+  exit();
+}
@@ -130,6 +130,47 @@ xchg(volatile uint *addr, uint newval)
   return result;
 }
 
+// Low 32 bits of the time-stamp counter.
+static inline uint
+rdtsc(void)
+{
+  uint lo, hi;
+
+  asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+  return lo;
+}
+
+// The full 64-bit time-stamp counter. Use this for intervals
+// that may exceed 2^32 cycles (about a second).
+static inline uint64
+rdtsc64(void)
+{
+  uint lo, hi;
+
+  asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64)hi << 32) | lo;
+}
+
+// Index of the least significant set bit. Undefined if v == 0.
+static inline uint
+bsf(uint v)
+{
+  uint r;
+
+  asm volatile("bsfl %1,%0" : "=r" (r) : "rm" (v) : "cc");
+  return r;
+}
+
+// Index of the most significant set bit. Undefined if v == 0.
+static inline uint
+bsr(uint v)
+{
+  uint r;
+
+  asm volatile("bsrl %1,%0" : "=r" (r) : "rm" (v) : "cc");
+  return r;
+}
+
 static inline uint
 rcr2(void)
 {
@@ -26,9 +26,12 @@
 #include "fs.h"
 #include "buf.h"
 
+// buf는 slab에서 필요할 때 할당. NBUF개까지는 새로 만들고 그 이후에는 재사용하며,
+// 재사용할 수 있는 buf가 없을 때만 더 늘림. 넘친 만큼은 brelse에서 반환
 struct {
   struct spinlock lock;
-  struct buf buf[NBUF];
+  struct kmem_cache *cache;
+  int nbuf;             // 현재 buf 수
 
   // Linked list of all buffers, through prev/next.
   // head.next is most recently used.
@@ -38,21 +41,31 @@ struct {
 void
 binit(void)
 {
-  struct buf *b;
-
   initlock(&bcache.lock, "bcache");
+  bcache.cache = kmem_cache_create("buf", sizeof(struct buf));
 
 //PAGEBREAK!
   // Create linked list of buffers
   bcache.head.prev = &bcache.head;
   bcache.head.next = &bcache.head;
-  for(b = bcache.buf; b < bcache.buf+NBUF; b++){
-    b->next = bcache.head.next;
-    b->prev = &bcache.head;
-    initsleeplock(&b->lock, "buffer");
-    bcache.head.next->prev = b;
-    bcache.head.next = b;
-  }
+}
+
+// 새 buf를 만들어 MRU 위치에 넣음. bcache.lock 필요
+static struct buf*
+bnew(void)
+{
+  struct buf *b;
+
+  if((b = kmem_cache_alloc(bcache.cache)) == 0)
+    return 0;
+  memset(b, 0, sizeof(*b));
+  initsleeplock(&b->lock, "buffer");
+  b->next = bcache.head.next;
+  b->prev = &bcache.head;
+  bcache.head.next->prev = b;
+  bcache.head.next = b;
+  bcache.nbuf++;
+  return b;
 }
 
 // Look through buffer cache for block on device dev.
@@ -61,7 +74,7 @@ binit(void)
 static struct buf*
 bget(uint dev, uint blockno)
 {
-  struct buf *b;
+  struct buf *b, *p;
 
   acquire(&bcache.lock);
 
@@ -78,18 +91,22 @@ bget(uint dev, uint blockno)
   // Not cached; recycle an unused buffer.
   // Even if refcnt==0, B_DIRTY indicates a buffer is in use
   // because log.c has modified it but not yet committed it.
-  for(b = bcache.head.prev; b != &bcache.head; b = b->prev){
-    if(b->refcnt == 0 && (b->flags & B_DIRTY) == 0) {
-      b->dev = dev;
-      b->blockno = blockno;
-      b->flags = 0;
-      b->refcnt = 1;
-      release(&bcache.lock);
-      acquiresleep(&b->lock);
-      return b;
-    }
-  }
-  panic("bget: no buffers");
+  // NBUF개까지는 새로 만들고, 재사용할 buf가 없을 때만 더 만듦
+  b = 0;
+  if(bcache.nbuf < NBUF)
+    b = bnew();
+  for(p = bcache.head.prev; b == 0 && p != &bcache.head; p = p->prev)
+    if(p->refcnt == 0 && (p->flags & B_DIRTY) == 0)
+      b = p;
+  if(b == 0 && (b = bnew()) == 0)
+    panic("bget: no buffers");
+  b->dev = dev;
+  b->blockno = blockno;
+  b->flags = 0;
+  b->refcnt = 1;
+  release(&bcache.lock);
+  acquiresleep(&b->lock);
+  return b;
 }
 
 // Return a locked buf with the contents of the indicated block.
@@ -107,6 +124,17 @@ bread(uint dev, uint blockno)
   return b;
 }
 
+// 내용 전체를 덮어쓸 블록. 디스크에서 읽지 않고 잠긴 buf를 반환
+struct buf*
+bgetw(uint dev, uint blockno)
+{
+  struct buf *b;
+
+  b = bget(dev, blockno);
+  b->flags |= B_VALID;
+  return b;
+}
+
 // Write b's contents to disk.  Must be locked.
 void
 bwrite(struct buf *b)
@@ -122,6 +150,8 @@ bwrite(struct buf *b)
 void
 brelse(struct buf *b)
 {
+  struct buf *prev;
+
   if(!holdingsleep(&b->lock))
     panic("brelse");
 
@@ -138,6 +168,17 @@ brelse(struct buf *b)
     bcache.head.next->prev = b;
     bcache.head.next = b;
   }
+
+  // NBUF개를 넘었다면 가장 오래 쓰지 않은 깨끗한 buf부터 반환
+  for(b = bcache.head.prev; bcache.nbuf > NBUF && b != &bcache.head; b = prev){
+    prev = b->prev;
+    if(b->refcnt == 0 && (b->flags & B_DIRTY) == 0){
+      b->next->prev = b->prev;
+      b->prev->next = b->next;
+      bcache.nbuf--;
+      kmem_cache_free(bcache.cache, b);
+    }
+  }
   
   release(&bcache.lock);
 }
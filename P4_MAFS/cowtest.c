@@ -0,0 +1,68 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// copy-on-write fork 테스트
+// 1. 큰 힙을 가진 프로세스를 fork해도 물리 페이지 수가 늘지 않고, 쓰는 페이지만 복사되는지
+// 2. fork 이후 부모와 자식의 쓰기가 서로 보이지 않는지
+// 3. ssualloc으로 예약만 된 페이지가 자식에서도 처음 접근할 때 할당되는지
+// 4. 큰 힙 프로세스의 fork 시간
+
+#define PGSIZE 4096
+#define HEAPPAGES 512	// 2MB
+#define NFORK 20
+
+int main(void)
+{
+	char *heap, *lazy;
+	int i, pid, before, ok;
+	uint start;
+
+	heap = sbrk(HEAPPAGES*PGSIZE);
+	if(heap == (char*)-1) {
+		printf(1, "cowtest: sbrk failed\n");
+		exit();
+	}
+	for(i = 0; i < HEAPPAGES; i++)
+		heap[i*PGSIZE] = 'p';
+	lazy = (char*)ssualloc(4*PGSIZE, 0);
+	if((int)lazy < 0) {
+		printf(1, "cowtest: ssualloc failed\n");
+		exit();
+	}
+
+	if((pid = fork()) == 0) {
+		before = getpp();
+		printf(1, "child after fork: physical pages %d\n", before);
+		for(i = 0; i < HEAPPAGES; i += 2) // 절반의 페이지에만 씀
+			heap[i*PGSIZE] = 'c';
+		printf(1, "child after writing %d pages: physical pages %d\n", HEAPPAGES/2, getpp());
+		lazy[0] = 'c';
+		printf(1, "child after touching a lazy page: physical pages %d\n", getpp());
+		sleep(10); // 부모가 쓸 때까지 기다림
+		ok = 1;
+		for(i = 0; i < HEAPPAGES; i++)
+			if(heap[i*PGSIZE] != (i % 2 ? 'p' : 'c'))
+				ok = 0;
+		printf(1, "child sees its own data: %s\n", ok ? "ok" : "FAILED");
+		exit();
+	}
+	for(i = 1; i < HEAPPAGES; i += 2) // 자식이 쓰지 않는 페이지에 부모가 씀
+		heap[i*PGSIZE] = 'P';
+	lazy[PGSIZE] = 'P';
+	wait();
+	ok = lazy[0] == 0;
+	for(i = 0; i < HEAPPAGES; i++)
+		if(heap[i*PGSIZE] != (i % 2 ? 'P' : 'p'))
+			ok = 0;
+	printf(1, "parent sees its own data: %s\n", ok ? "ok" : "FAILED");
+
+	start = uptime();
+	for(i = 0; i < NFORK; i++) {
+		if((pid = fork()) == 0)
+			exit();
+		wait();
+	}
+	printf(1, "%d forks of a %d page process in %d ticks\n", NFORK, getpp(), uptime() - start);
+	exit();
+}
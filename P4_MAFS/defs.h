@@ -2,17 +2,21 @@ struct buf;
 struct context;
 struct file;
 struct inode;
+struct kmem_cache;
 struct pipe;
 struct proc;
 struct rtcdate;
+struct shm;
 struct spinlock;
 struct sleeplock;
 struct stat;
 struct superblock;
+struct vma;
 
 // bio.c
 void            binit(void);
 struct buf*     bread(uint, uint);
+struct buf*     bgetw(uint, uint);
 void            brelse(struct buf*);
 void            bwrite(struct buf*);
 
@@ -68,6 +72,12 @@ char*           kalloc(void);
 void            kfree(char*);
 void            kinit1(void*, void*);
 void            kinit2(void*, void*);
+void            kref(char*);
+char*           kalloc_pages(int);
+void            kfree_pages(char*, int);
+void            kmemstat(int*);
+int             kfreepages(void);
+int             krefcnt(char*);
 
 // kbd.c
 void            kbdintr(void);
@@ -95,7 +105,15 @@ void            mpinit(void);
 void            picenable(int);
 void            picinit(void);
 
+// pcache.c
+void            pcacheinit(void);
+char*           pcache_get(struct inode*, uint);
+void            pcache_update(struct inode*, uint, char*, uint);
+void            pcache_inval(struct inode*);
+int             pcache_shrink(void);
+
 // pipe.c
+void            pipeinit(void);
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
 int             piperead(struct pipe*, char*, int);
@@ -124,6 +142,21 @@ void            yield(void);
 // swtch.S
 void            swtch(struct context**, struct context*);
 
+// slab.c
+void            slabinit(void);
+struct kmem_cache* kmem_cache_create(char*, uint);
+void*           kmem_cache_alloc(struct kmem_cache*);
+void            kmem_cache_free(struct kmem_cache*, void*);
+
+// swap.c
+void            swapinit(void);
+int             swap_alloc(void);
+void            swap_dup(int);
+void            swap_free(int);
+void            swap_write(int, char*);
+void            swap_read(int, char*);
+void            swapstat(uint*);
+
 // spinlock.c
 void            acquire(struct spinlock*);
 void            getcallerpcs(void*, uint*);
@@ -133,6 +166,13 @@ void            release(struct spinlock*);
 void            pushcli(void);
 void            popcli(void);
 
+// shm.c
+void            shminit(void);
+struct shm*     shm_get(int, uint);
+void            shm_dup(struct shm*);
+void            shm_put(struct shm*);
+char*           shm_page(struct shm*, uint, char*);
+
 // sleeplock.c
 void            acquiresleep(struct sleeplock*);
 void            releasesleep(struct sleeplock*);
@@ -180,15 +220,28 @@ int             deallocuvm(pde_t*, uint, uint);
 void            freevm(pde_t*);
 void            inituvm(pde_t*, char*, uint);
 int             loaduvm(pde_t*, char*, struct inode*, uint, uint);
-pde_t*          copyuvm(pde_t*, uint);
+pde_t*          copyuvm(pde_t*, uint, struct vma*);
 void            switchuvm(struct proc*);
 void            switchkvm(void);
 int             copyout(pde_t*, uint, void*, uint);
 void            clearpteu(pde_t *pgdir, char *uva);
 int             vm_getvp(pde_t *pgdir);
 int             vm_getpp(pde_t *pgdir);
-int             vm_ssualloc(pde_t *pgdir, uint oldsz, uint newsz);
-void            ssu_palloc(pde_t *pgdir, uint va);
+int             vm_ssualloc(pde_t *pgdir, uint oldsz, uint newsz, int flags);
+void            ssu_addregion(struct proc *p, uint start, uint end);
+int             vm_ssurelease(pde_t *pgdir, uint start, uint end);
+int             ssu_palloc(pde_t *pgdir, uint va);
+int             vm_pgfault(struct proc *p, uint va, uint err);
+void            tlb_shootdown(pde_t *pgdir, uint start, uint end);
+int             swap_out(struct proc *p);
+int             vm_resident(struct proc *p, uint va, uint n);
+int             vm_mapfile(pde_t *pgdir, struct vma *v, uint start, uint end, uint off, uint filesz);
+int             vma_overlap(struct proc *p, uint start, uint end);
+void            vma_dup(struct vma *dst, struct vma *src);
+void            vma_release(struct vma *v, pde_t *pgdir);
+int             vm_mmap(struct proc *p, struct inode *ip, struct shm *s, uint off, uint len, int flags);
+int             vm_munmap(struct proc *p, uint start, uint end);
+void            vm_fsync(struct proc *p, struct inode *ip);
 
 // number of elements in fixed-size array
 #define NELEM(x) (sizeof(x)/sizeof((x)[0]))
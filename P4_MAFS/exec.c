@@ -11,14 +11,17 @@ int
 exec(char *path, char **argv)
 {
   char *s, *last;
-  int i, off;
+  int i, off, nv;
   uint argc, sz, sp, ustack[3+MAXARG+1];
   struct elfhdr elf;
   struct inode *ip;
   struct proghdr ph;
   pde_t *pgdir, *oldpgdir;
+  struct vma vma[NVMA];
   struct proc *curproc = myproc();
 
+  memset(vma, 0, sizeof(vma));
+
   begin_op();
 
   if((ip = namei(path)) == 0){
@@ -38,8 +41,9 @@ exec(char *path, char **argv)
   if((pgdir = setupkvm()) == 0)
     goto bad;
 
-  // Load program into memory.
+  // Map program segments. 페이지는 처음 접근할 때 파일에서 읽음(vm_pgfault)
   sz = 0;
+  nv = 0;
   for(i=0, off=elf.phoff; i<elf.phnum; i++, off+=sizeof(ph)){
     if(readi(ip, (char*)&ph, off, sizeof(ph)) != sizeof(ph))
       goto bad;
@@ -49,13 +53,18 @@ exec(char *path, char **argv)
       goto bad;
     if(ph.vaddr + ph.memsz < ph.vaddr)
       goto bad;
-    if((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
+    if(ph.vaddr % PGSIZE != 0 || ph.vaddr < sz || ph.vaddr + ph.memsz >= KERNBASE)
+      goto bad;
+    if(nv == NVMA)
       goto bad;
-    if(ph.vaddr % PGSIZE != 0)
+    if(vm_ssualloc(pgdir, sz, ph.vaddr, 0) < 0) // 세그먼트 사이의 빈 공간
       goto bad;
-    if(loaduvm(pgdir, (char*)ph.vaddr, ip, ph.off, ph.filesz) < 0)
+    if(vm_mapfile(pgdir, &vma[nv++], ph.vaddr, ph.vaddr + ph.memsz, ph.off, ph.filesz) < 0)
       goto bad;
+    sz = ph.vaddr + ph.memsz;
   }
+  for(i = 0; i < nv; i++)
+    vma[i].ip = idup(ip);
   iunlockput(ip);
   end_op();
   ip = 0;
@@ -97,9 +106,13 @@ exec(char *path, char **argv)
   oldpgdir = curproc->pgdir;
   curproc->pgdir = pgdir;
   curproc->sz = sz;
+  curproc->nssureg = 0;
+  curproc->swaphand = 0;
   curproc->tf->eip = elf.entry;  // main
   curproc->tf->esp = sp;
   switchuvm(curproc);
+  vma_release(curproc->vma, oldpgdir);
+  memmove(curproc->vma, vma, sizeof(vma));
   freevm(oldpgdir);
   return 0;
 
@@ -110,5 +123,6 @@ exec(char *path, char **argv)
     iunlockput(ip);
     end_op();
   }
+  vma_release(vma, 0);
   return -1;
 }
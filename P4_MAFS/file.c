@@ -11,15 +11,18 @@
 #include "file.h"
 
 struct devsw devsw[NDEV];
+// file 구조체는 고정 크기 표 대신 slab에서 필요할 때마다 할당.
+// ftable.lock은 ref를 보호
 struct {
   struct spinlock lock;
-  struct file file[NFILE];
+  struct kmem_cache *cache;
 } ftable;
 
 void
 fileinit(void)
 {
   initlock(&ftable.lock, "ftable");
+  ftable.cache = kmem_cache_create("file", sizeof(struct file));
 }
 
 // Allocate a file structure.
@@ -28,16 +31,11 @@ filealloc(void)
 {
   struct file *f;
 
-  acquire(&ftable.lock);
-  for(f = ftable.file; f < ftable.file + NFILE; f++){
-    if(f->ref == 0){
-      f->ref = 1;
-      release(&ftable.lock);
-      return f;
-    }
-  }
-  release(&ftable.lock);
-  return 0;
+  if((f = kmem_cache_alloc(ftable.cache)) == 0)
+    return 0;
+  memset(f, 0, sizeof(*f));
+  f->ref = 1;
+  return f;
 }
 
 // Increment ref count for file f.
@@ -66,9 +64,8 @@ fileclose(struct file *f)
     return;
   }
   ff = *f;
-  f->ref = 0;
-  f->type = FD_NONE;
   release(&ftable.lock);
+  kmem_cache_free(ftable.cache, f);
 
   if(ff.type == FD_PIPE)
     pipeclose(ff.pipe, ff.writable);
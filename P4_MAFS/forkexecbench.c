@@ -0,0 +1,73 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+
+// fork+exec 비용 측정
+// NITER번 fork한 자식이 자신을 "child" 인자로 exec해 바로 종료하고 부모가 wait한다.
+// 한 번에 걸린 시간(us)과, 자식 프로세스가 살아있는 동안 쓰는 물리 페이지 수를 출력.
+// 커널 영역 매핑을 공유하므로 페이지 디렉토리 외에 커널용 페이지 테이블을 할당하지 않음.
+// 같은 프로그램을 실행 중인 두 번째 프로세스는 프로그램 페이지를 page cache에서 공유하므로
+// 첫 번째보다 적은 페이지를 씀
+// 사용법: forkexecbench
+
+#define NITER 500
+#define HOLDTICKS 100
+
+int freepages(void)
+{
+	int nfree[MAXORDER+2];
+	int k, total = 0;
+
+	kmemstat(nfree);
+	for(k = 0; k <= MAXORDER; k++)
+		total += nfree[k] << k;
+	return total + nfree[MAXORDER+1];
+}
+
+int main(int argc, char *argv[])
+{
+	char *args[] = { "forkexecbench", "child", 0 };
+	char *hold[] = { "forkexecbench", "hold", 0 };
+	int i, before, first;
+	uint start, elapsed;
+
+	if(argc > 1 && strcmp(argv[1], "child") == 0)
+		exit();
+	if(argc > 1 && strcmp(argv[1], "hold") == 0) { // 부모가 잴 동안 살아있음
+		sleep(HOLDTICKS);
+		exit();
+	}
+
+	before = freepages();
+	if(fork() == 0) {
+		exec("forkexecbench", hold);
+		exit();
+	}
+	sleep(HOLDTICKS/2); // 자식이 exec를 마칠 때까지
+	first = before - freepages();
+	printf(1, "one exec'd process uses %d physical pages\n", first);
+	before = freepages();
+	if(fork() == 0) { // 첫 번째 자식이 살아있는 동안 하나 더
+		exec("forkexecbench", hold);
+		exit();
+	}
+	sleep(HOLDTICKS/4);
+	printf(1, "a second one uses %d physical pages\n", before - freepages());
+	wait();
+	wait();
+
+	start = uptime();
+	for(i = 0; i < NITER; i++) {
+		if(fork() == 0) {
+			exec("forkexecbench", args);
+			printf(1, "forkexecbench: exec failed\n");
+			exit();
+		}
+		wait();
+	}
+	elapsed = uptime() - start;
+	// 1 tick = 10ms
+	printf(1, "%d fork+exec+wait in %d ticks, %d us each\n", NITER, elapsed, elapsed * 10000 / NITER);
+	exit();
+}
@@ -172,26 +172,26 @@ bfree(int dev, uint b)
 // dev, and inum.  One must hold ip->lock in order to
 // read or write that inode's ip->valid, ip->size, ip->type, &c.
 
+// 캐시 항목은 slab에서 필요할 때 할당해 list에 연결. 사용하지 않는(ref == 0) 항목이
+// NINODE개보다 많이 쌓이지 않도록 iput에서 반환함
 struct {
   struct spinlock lock;
-  struct inode inode[NINODE];
+  struct kmem_cache *cache;
+  struct inode *list;   // 캐시에 있는 모든 inode. ip->next로 연결
+  int ninode;           // list의 길이
 } icache;
 
 void
 iinit(int dev)
 {
-  int i = 0;
-  
   initlock(&icache.lock, "icache");
-  for(i = 0; i < NINODE; i++) {
-    initsleeplock(&icache.inode[i].lock, "inode");
-  }
+  icache.cache = kmem_cache_create("inode", sizeof(struct inode));
 
   readsb(dev, &sb);
   cprintf("sb: size %d nblocks %d ninodes %d nlog %d logstart %d\
- inodestart %d bmap start %d\n", sb.size, sb.nblocks,
+ inodestart %d bmap start %d swap start %d nswap %d\n", sb.size, sb.nblocks,
           sb.ninodes, sb.nlog, sb.logstart, sb.inodestart,
-          sb.bmapstart);
+          sb.bmapstart, sb.swapstart, sb.nswap);
 }
 
 static struct inode* iget(uint dev, uint inum);
@@ -257,7 +257,7 @@ iget(uint dev, uint inum)
 
   // Is the inode already cached?
   empty = 0;
-  for(ip = &icache.inode[0]; ip < &icache.inode[NINODE]; ip++){
+  for(ip = icache.list; ip; ip = ip->next){
     if(ip->ref > 0 && ip->dev == dev && ip->inum == inum){
       ip->ref++;
       release(&icache.lock);
@@ -267,6 +267,16 @@ iget(uint dev, uint inum)
       empty = ip;
   }
 
+  // NINODE개까지는 새로 할당하고, 그 이후에는 빈 항목이 없을 때만 늘림
+  if((empty == 0 || icache.ninode < NINODE) &&
+     (ip = kmem_cache_alloc(icache.cache)) != 0){
+    initsleeplock(&ip->lock, "inode");
+    ip->next = icache.list;
+    icache.list = ip;
+    icache.ninode++;
+    empty = ip;
+  }
+
   // Recycle an inode cache entry.
   if(empty == 0)
     panic("iget: no inodes");
@@ -341,6 +351,8 @@ iunlock(struct inode *ip)
 void
 iput(struct inode *ip)
 {
+  struct inode **pp;
+
   acquiresleep(&ip->lock);
   if(ip->valid && ip->nlink == 0){
     acquire(&icache.lock);
@@ -357,7 +369,13 @@ iput(struct inode *ip)
   releasesleep(&ip->lock);
 
   acquire(&icache.lock);
-  ip->ref--;
+  if(--ip->ref == 0 && icache.ninode > NINODE){ // 쓰는 곳이 없고 캐시가 넘침
+    for(pp = &icache.list; *pp != ip; pp = &(*pp)->next)
+      ;
+    *pp = ip->next;
+    icache.ninode--;
+    kmem_cache_free(icache.cache, ip);
+  }
   release(&icache.lock);
 }
 
@@ -479,6 +497,7 @@ itrunc(struct inode *ip)
 
   ip->size = 0;
   iupdate(ip);
+  pcache_inval(ip); // inode 번호가 재사용되기 전에 캐시 페이지를 버림
 }
 
 // Copy stat information from inode.
@@ -549,6 +568,7 @@ writei(struct inode *ip, char *src, uint off, uint n)
     m = min(n - tot, BSIZE - off%BSIZE); // 블록이 꽉찼다면 0, 데이터 끝이라면 데이터 끝 블록에 담긴 데이터 크기
     memmove(bp->data + off%BSIZE, src, m); // 해당 블록에 (실제론 buf) 블록단위로 쓰기함
     log_write(bp);
+    pcache_update(ip, off, (char*)bp->data + off%BSIZE, m); // 캐시된 페이지에도 반영
     brelse(bp);
   }
 
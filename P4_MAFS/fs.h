@@ -19,6 +19,8 @@ struct superblock {
   uint logstart;     // Block number of first log block
   uint inodestart;   // Block number of first inode block
   uint bmapstart;    // Block number of first free map block
+  uint swapstart;    // 스왑 영역의 첫 블록 번호
+  uint nswap;        // 스왑 슬롯(페이지) 수
 };
 
 #define N_LAYER_LEN 4 // 레이어 개수
@@ -0,0 +1,94 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+
+// 4MB 페이지(superpage) 테스트
+// 1. 4MB로 정렬된 sbrk 영역이 4MB 페이지로 할당되어 페이지 테이블 페이지가 줄어드는지
+//    (할당 전후 빈 물리 페이지 수의 차이가 데이터 페이지 수와 같아야 함)
+// 2. 같은 크기의 4KB 페이지 영역(ssualloc)과 무작위 접근 시간 비교. TLB miss 차이
+// 3. fork하거나 sbrk로 일부를 줄인 뒤에도(4KB 페이지로 쪼개짐) 데이터가 그대로인지
+
+#define PGSIZE 4096
+#define SPSIZE (1024*PGSIZE)
+#define NSUPER 4	// 16MB
+#define NACCESS 4000000
+
+int freepages(void)
+{
+	int nfree[MAXORDER+2];
+	int k, total = 0;
+
+	kmemstat(nfree);
+	for(k = 0; k <= MAXORDER; k++)
+		total += nfree[k] << k;
+	return total + nfree[MAXORDER+1];
+}
+
+// 영역 base의 무작위 위치를 NACCESS번 읽고 쓰는 데 걸린 tick
+uint randwalk(char *base)
+{
+	uint start, x = 1;
+	int i;
+
+	start = uptime();
+	for(i = 0; i < NACCESS; i++) {
+		x = x * 1103515245 + 12345;
+		base[(x >> 4) % (NSUPER*SPSIZE)]++;
+	}
+	return uptime() - start;
+}
+
+int check(char *base, int npages)
+{
+	int i;
+
+	for(i = 0; i < npages; i++)
+		if(base[i*PGSIZE] != (char)i)
+			return 0;
+	return 1;
+}
+
+int main(void)
+{
+	char *huge, *small;
+	int i, before, used, pid;
+	uint cur;
+
+	cur = (uint)sbrk(0); // 힙 끝을 4MB 경계에 맞춤
+	sbrk((SPSIZE - cur % SPSIZE) % SPSIZE);
+
+	before = freepages();
+	huge = sbrk(NSUPER*SPSIZE);
+	if(huge == (char*)-1) {
+		printf(1, "hugetest: sbrk failed\n");
+		exit();
+	}
+	used = before - freepages();
+	printf(1, "sbrk %d pages: %d physical pages used (%d for page tables)\n",
+		NSUPER*SPSIZE/PGSIZE, used, used - NSUPER*SPSIZE/PGSIZE);
+
+	small = (char*)ssualloc(NSUPER*SPSIZE, 0);
+	if((int)small < 0) {
+		printf(1, "hugetest: ssualloc failed\n");
+		exit();
+	}
+	for(i = 0; i < NSUPER*SPSIZE/PGSIZE; i++) // 4KB 페이지로 미리 할당
+		small[i*PGSIZE] = 0;
+	printf(1, "random access: 4MB pages %d ticks, 4KB pages %d ticks\n",
+		randwalk(huge), randwalk(small));
+
+	for(i = 0; i < NSUPER*SPSIZE/PGSIZE; i++)
+		huge[i*PGSIZE] = i;
+	if((pid = fork()) == 0) {
+		printf(1, "child sees parent data: %s\n", check(huge, NSUPER*SPSIZE/PGSIZE) ? "ok" : "FAILED");
+		for(i = 0; i < NSUPER*SPSIZE/PGSIZE; i++)
+			huge[i*PGSIZE] = -1;
+		exit();
+	}
+	wait();
+	printf(1, "parent data after fork: %s\n", check(huge, NSUPER*SPSIZE/PGSIZE) ? "ok" : "FAILED");
+	sbrk(-(NSUPER*SPSIZE + PGSIZE)); // ssualloc 영역 전체와 마지막 4MB 페이지의 한 페이지를 반환
+	printf(1, "data after shrinking: %s\n", check(huge, NSUPER*SPSIZE/PGSIZE - 1) ? "ok" : "FAILED");
+	exit();
+}
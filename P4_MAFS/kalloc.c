@@ -8,6 +8,7 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "spinlock.h"
+#include "x86.h"
 
 void freerange(void *vstart, void *vend);
 extern char end[]; // first address after kernel loaded from ELF file
@@ -15,14 +16,106 @@ extern char end[]; // first address after kernel loaded from ELF file
 
 struct run {
   struct run *next; // 페이지 단위 포인터
+  struct run *prev; // buddy 목록에서 O(1)로 빼기 위함
 };
 
+// 물리 메모리는 binary buddy 방식으로 관리. 차수 k의 블록은 2^k개의 연속된 페이지이고
+// 물리 주소가 2^k 페이지 단위로 정렬되어 있음. 블록을 반환할 때 짝(buddy)도 비어있다면
+// 합쳐서 한 차수 위로 올림
 struct {
   struct spinlock lock;
   int use_lock;
-  struct run *freelist; // 그냥 페이지 단위 포인터임
+  struct run *freelist[MAXORDER+1]; // 차수별 빈 블록 목록
+  int nfree[MAXORDER+1];            // 차수별 빈 블록 수
 } kmem; // kalloc에서 주로 씀
 
+#define NPHYSPAGE (PHYSTOP/PGSIZE)
+#define PFN(v)    (V2P(v)/PGSIZE)
+
+// 빈 블록의 첫 페이지라면 그 블록의 차수+1, 아니면 0. kmem.lock으로 보호
+static uchar pgorder[NPHYSPAGE];
+
+// CPU별 빈 페이지 캐시(magazine). 자신의 CPU 것만 인터럽트를 끈 채로 쓰므로 잠금이 필요 없음.
+// 비면 buddy에서 KCACHEBATCH개를 한 번에 가져오고, KCACHEMAX개가 넘으면
+// KCACHEBATCH개를 한 번에 돌려줌. kmem.lock은 이 경계에서만 잡는다
+#define KCACHEBATCH 32
+#define KCACHEMAX   (2*KCACHEBATCH)
+
+struct kcache {
+  struct run *freelist;
+  int nfree;
+} kcache[NCPU];
+
+// 물리 페이지별 참조 수. copy-on-write로 여러 페이지 테이블이 같은 페이지를 가리킬 수 있으므로
+// kfree는 마지막 참조가 사라질 때만 실제로 반환함. 원자적 명령으로 갱신해 잠금이 필요 없음
+static volatile int pgref[NPHYSPAGE];
+
+#define PGREF(v) (&pgref[PFN(v)])
+
+static void
+buddy_push(struct run *r, int order)
+{
+  r->prev = 0;
+  r->next = kmem.freelist[order];
+  if(r->next)
+    r->next->prev = r;
+  kmem.freelist[order] = r;
+  kmem.nfree[order]++;
+  pgorder[PFN(r)] = order + 1;
+}
+
+static void
+buddy_remove(struct run *r, int order)
+{
+  if(r->prev)
+    r->prev->next = r->next;
+  else
+    kmem.freelist[order] = r->next;
+  if(r->next)
+    r->next->prev = r->prev;
+  kmem.nfree[order]--;
+  pgorder[PFN(r)] = 0;
+}
+
+// 차수 order의 블록 v를 반환하고 짝이 비어있는 동안 합쳐 올림. kmem.lock 필요
+static void
+buddy_free(char *v, int order)
+{
+  uint pfn, bpfn;
+
+  pfn = PFN(v);
+  while(order < MAXORDER){
+    bpfn = pfn ^ (1 << order);
+    if(bpfn >= NPHYSPAGE || pgorder[bpfn] != order + 1) // 짝이 없거나 쪼개져 사용 중
+      break;
+    buddy_remove((struct run*)P2V(bpfn*PGSIZE), order);
+    pfn &= ~(1 << order);
+    order++;
+  }
+  buddy_push((struct run*)P2V(pfn*PGSIZE), order);
+}
+
+// 차수 order의 블록을 할당. 맞는 블록이 없으면 큰 블록을 반씩 쪼개고
+// 남은 절반은 각 차수의 목록에 넣음. kmem.lock 필요
+static char*
+buddy_alloc(int order)
+{
+  struct run *r;
+  int k;
+
+  for(k = order; k <= MAXORDER && kmem.freelist[k] == 0; k++)
+    ;
+  if(k > MAXORDER)
+    return 0;
+  r = kmem.freelist[k];
+  buddy_remove(r, k);
+  while(k > order){
+    k--;
+    buddy_push((struct run*)((char*)r + (PGSIZE << k)), k);
+  }
+  return (char*)r;
+}
+
 // Initialization happens in two phases.
 // 1. main() calls kinit1() while still using entrypgdir to place just
 // the pages mapped by entrypgdir on free list.
@@ -44,14 +137,17 @@ kinit2(void *vstart, void *vend)
 }
 // Todo: kinit 사용처 분석 후 kfree에 대해 분석하기   
 
-// 해당 범위의 메모리들을 kfree시켜서 모조리 freelist에 넣어 kalloc 할 수 있게 만듦
+// 해당 범위의 메모리들을 kfree시켜서 모조리 buddy에 넣어 kalloc 할 수 있게 만듦.
+// 이웃한 페이지끼리 합쳐지므로 끝나면 대부분 MAXORDER 블록으로 모임
 void
 freerange(void *vstart, void *vend)
 {
   char *p;
   p = (char*)PGROUNDUP((uint)vstart);
-  for(; p + PGSIZE <= (char*)vend; p += PGSIZE)
+  for(; p + PGSIZE <= (char*)vend; p += PGSIZE){
+    *PGREF(p) = 1;
     kfree(p);
+  }
 }
 
 // 인자로 받은 포인터에대해 해당 페이지에 대한 값을 페이지 크기만큼 1로 초기화하고,
@@ -65,20 +161,39 @@ void
 kfree(char *v)
 {
   struct run *r;
+  struct kcache *kc;
+  int i;
 
   if((uint)v % PGSIZE || v < end || V2P(v) >= PHYSTOP)
     panic("kfree");
 
+  if(atomic_add(PGREF(v), -1) > 0) // 아직 다른 페이지 테이블이 쓰는 중
+    return;
+
   // Fill with junk to catch dangling refs.
   memset(v, 1, PGSIZE);
 
-  if(kmem.use_lock)
-    acquire(&kmem.lock);
+  if(!kmem.use_lock){ // kinit 중에는 CPU가 하나뿐이고 cpuid()도 아직 쓸 수 없음
+    buddy_free(v, 0);
+    return;
+  }
+
+  pushcli();
+  kc = &kcache[cpuid()];
   r = (struct run*)v;
-  r->next = kmem.freelist;
-  kmem.freelist = r;
-  if(kmem.use_lock)
+  r->next = kc->freelist;
+  kc->freelist = r;
+  if(++kc->nfree > KCACHEMAX){ // KCACHEBATCH개를 한 번에 buddy로 반환
+    acquire(&kmem.lock);
+    for(i = 0; i < KCACHEBATCH; i++){
+      r = kc->freelist;
+      kc->freelist = r->next;
+      buddy_free((char*)r, 0);
+    }
     release(&kmem.lock);
+    kc->nfree -= KCACHEBATCH;
+  }
+  popcli();
 }
 
 // 호출당 4096 바이트짜리 페이지의 물리메모리를 할당해줌. 커널만 쓸수 있는 포인터
@@ -89,14 +204,123 @@ char*
 kalloc(void)
 {
   struct run *r; // 여기에는 이전에 4096바이트 단위 통으로 쪼개놓은 할당된 페이지 단위 포인터가 있음
+  struct kcache *kc;
 
-  if(kmem.use_lock)
+  if(!kmem.use_lock){
+    if((r = (struct run*)buddy_alloc(0)) != 0)
+      *PGREF(r) = 1;
+    return (char*)r;
+  }
+
+  pushcli();
+  kc = &kcache[cpuid()];
+  if(kc->nfree == 0){ // buddy에서 최대 KCACHEBATCH개를 한 번에 가져옴
     acquire(&kmem.lock);
-  r = kmem.freelist;
+    while(kc->nfree < KCACHEBATCH && (r = (struct run*)buddy_alloc(0)) != 0){
+      r->next = kc->freelist;
+      kc->freelist = r;
+      kc->nfree++;
+    }
+    release(&kmem.lock);
+  }
+  r = kc->freelist;
+  if(r){
+    kc->freelist = r->next;
+    kc->nfree--;
+  }
+  popcli();
   if(r)
-    kmem.freelist = r->next;
+    *PGREF(r) = 1;
+  return (char*)r;
+}
+
+// 물리적으로 연속된 2^order개의 페이지를 할당. 첫 페이지 주소는 (PGSIZE << order)로
+// 정렬되어 있음. 없으면 0. kfree_pages로 같은 order를 주어 반환
+char*
+kalloc_pages(int order)
+{
+  char *v;
+  int i;
+
+  if(order == 0)
+    return kalloc();
+  if(order < 0 || order > MAXORDER)
+    return 0;
+  if(kmem.use_lock)
+    acquire(&kmem.lock);
+  v = buddy_alloc(order);
   if(kmem.use_lock)
     release(&kmem.lock);
-  return (char*)r;
+  if(v)
+    for(i = 0; i < (1 << order); i++)
+      *PGREF(v + i*PGSIZE) = 1;
+  return v;
+}
+
+void
+kfree_pages(char *v, int order)
+{
+  int i;
+
+  if(order == 0){
+    kfree(v);
+    return;
+  }
+  if(order < 0 || order > MAXORDER || V2P(v) % (PGSIZE << order) ||
+     v < end || V2P(v) + (PGSIZE << order) > PHYSTOP)
+    panic("kfree_pages");
+  for(i = 0; i < (1 << order); i++)
+    *PGREF(v + i*PGSIZE) = 0;
+  memset(v, 1, PGSIZE << order);
+  if(kmem.use_lock)
+    acquire(&kmem.lock);
+  buddy_free(v, order);
+  if(kmem.use_lock)
+    release(&kmem.lock);
+}
+
+// 단편화 통계. nfree[k]는 차수 k의 빈 블록 수(k = 0..MAXORDER),
+// nfree[MAXORDER+1]은 CPU별 캐시에 있어 buddy 밖에 있는 페이지 수
+void
+kmemstat(int *nfree)
+{
+  int k;
+
+  acquire(&kmem.lock);
+  for(k = 0; k <= MAXORDER; k++)
+    nfree[k] = kmem.nfree[k];
+  release(&kmem.lock);
+  nfree[MAXORDER+1] = 0;
+  for(k = 0; k < NCPU; k++) // 다른 CPU의 캐시는 잠금 없이 읽으므로 근사값
+    nfree[MAXORDER+1] += kcache[k].nfree;
+}
+
+// 빈 페이지 수. 잠금 없이 읽으므로 근사값
+int
+kfreepages(void)
+{
+  int k, n = 0;
+
+  for(k = 0; k <= MAXORDER; k++)
+    n += kmem.nfree[k] << k;
+  for(k = 0; k < NCPU; k++)
+    n += kcache[k].nfree;
+  return n;
+}
+
+// 페이지 v를 공유하는 참조를 하나 늘림. 각 참조는 kfree 한 번으로 반환
+void
+kref(char *v)
+{
+  if((uint)v % PGSIZE || v < end || V2P(v) >= PHYSTOP)
+    panic("kref");
+  atomic_add(PGREF(v), 1);
+}
+
+// 페이지 v의 참조 수
+int
+krefcnt(char *v)
+{
+  return *PGREF(v);
 }
 
@@ -0,0 +1,75 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// 병렬 페이지 할당 스트레스 테스트
+// NWORKER개의 프로세스가 BENCHTICKS 동안 sbrk로 NPAGE 페이지를 늘렸다 줄이고
+// fork/wait를 반복한다. 모든 할당이 kalloc/kfree를 거치므로 CPU 수(make qemu CPUS=n)를
+// 바꿔가며 초당 할당한 페이지 수를 비교하면 kalloc의 확장성을 볼 수 있다.
+// 사용법: kallocbench [nworker]
+
+#define NWORKER 4
+#define NPAGE 64
+#define BENCHTICKS 300
+#define TICKHZ 100	// 초당 타이머 tick
+#define PGSIZE 4096
+
+int worker(uint end)
+{
+	int pages = 0;
+	int pid;
+
+	while(uptime() < end) {
+		if(sbrk(NPAGE*PGSIZE) == (char*)-1) {
+			printf(1, "kallocbench: sbrk failed\n");
+			break;
+		}
+		sbrk(-NPAGE*PGSIZE);
+		pages += NPAGE;
+
+		// fork는 페이지 테이블과 사용자 메모리 페이지를 할당하고 exit/wait에서 반환
+		if((pid = fork()) == 0)
+			exit();
+		if(pid > 0)
+			wait();
+	}
+	return pages;
+}
+
+int main(int argc, char *argv[])
+{
+	int result[2];
+	int nworker, n, total = 0;
+	uint start, end;
+
+	nworker = argc > 1 ? atoi(argv[1]) : NWORKER;
+	if(pipe(result) < 0) {
+		printf(1, "kallocbench: pipe failed\n");
+		exit();
+	}
+
+	start = uptime();
+	end = start + BENCHTICKS;
+	for(int i = 0; i < nworker; i++) {
+		if(fork() == 0) {
+			close(result[0]);
+			n = worker(end);
+			write(result[1], &n, sizeof(n));
+			exit();
+		}
+	}
+	close(result[1]);
+
+	for(int i = 0; i < nworker; i++) {
+		if(read(result[0], &n, sizeof(n)) != sizeof(n))
+			break;
+		total += n;
+	}
+	for(int i = 0; i < nworker; i++)
+		wait();
+	end = uptime();
+
+	printf(1, "kallocbench: %d workers, %d pages in %d ticks, %d pages/sec\n",
+		nworker, total, end - start, total*TICKHZ/(end - start));
+	exit();
+}
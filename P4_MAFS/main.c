@@ -29,8 +29,13 @@ main(void)
   uartinit();      // serial port
   pinit();         // process table
   tvinit();        // trap vectors
+  slabinit();      // small object allocator
   binit();         // buffer cache
   fileinit();      // file table
+  pipeinit();      // pipe objects
+  swapinit();      // swap space
+  pcacheinit();    // page cache
+  shminit();       // shared memory segments
   ideinit();       // disk 
   startothers();   // start other processors
   // 앞서 4MB 담은 이후부터 물리메모리 꼭대기까지 kfree를 이용해 freelist에 담음
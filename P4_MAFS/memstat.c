@@ -0,0 +1,32 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+
+// 물리 메모리 단편화 통계 출력
+// 차수별 buddy 빈 블록 수와, 각 차수 이상의 연속 공간으로 쓸 수 없는 빈 메모리의 비율
+// (unusable free space index)을 보여준다. 100%에 가까울수록 그 크기의 연속 할당이 어려움
+
+int main(void)
+{
+	int nfree[MAXORDER+2];
+	int k, total = 0, usable;
+
+	if(kmemstat(nfree) < 0) {
+		printf(1, "memstat: kmemstat failed\n");
+		exit();
+	}
+	for(k = 0; k <= MAXORDER; k++)
+		total += nfree[k] << k;
+
+	printf(1, "order\tpages\tfree blocks\tunusable\n");
+	for(k = 0; k <= MAXORDER; k++) {
+		usable = 0;
+		for(int j = k; j <= MAXORDER; j++)
+			usable += nfree[j] << j;
+		printf(1, "%d\t%d\t%d\t\t%d%%\n", k, 1 << k, nfree[k],
+			total ? (total - usable) * 100 / total : 0);
+	}
+	printf(1, "free pages: %d in buddy, %d in per-cpu caches\n", total, nfree[MAXORDER+1]);
+	exit();
+}
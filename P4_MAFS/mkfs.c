@@ -23,6 +23,7 @@
 int nbitmap = FSSIZE/(BSIZE*8) + 1;
 int ninodeblocks = NINODES / IPB + 1;
 int nlog = LOGSIZE;
+int nswapblocks = NSWAPSLOT * (4096 / BSIZE); // 슬롯 하나가 4096바이트 페이지
 int nmeta;    // Number of meta blocks (boot, sb, nlog, inode, bitmap)
 int nblocks;  // Number of data blocks
 
@@ -92,18 +93,21 @@ main(int argc, char *argv[])
 
   // 1 fs block = 1 disk sector
   nmeta = 2 + nlog + ninodeblocks + nbitmap;
-  nblocks = FSSIZE - nmeta;
+  nblocks = FSSIZE - nswapblocks - nmeta;
 
-  sb.size = xint(FSSIZE);
+  // 스왑 영역은 디스크 맨 끝. 파일 시스템 크기(sb.size)에서 빼서 balloc이 쓰지 않게 함
+  sb.size = xint(FSSIZE - nswapblocks);
   sb.nblocks = xint(nblocks);
   sb.ninodes = xint(NINODES);
   sb.nlog = xint(nlog);
   sb.logstart = xint(2);
   sb.inodestart = xint(2+nlog);
   sb.bmapstart = xint(2+nlog+ninodeblocks);
+  sb.swapstart = xint(FSSIZE - nswapblocks);
+  sb.nswap = xint(NSWAPSLOT);
 
-  printf("nmeta %d (boot, super, log blocks %u inode blocks %u, bitmap blocks %u) blocks %d total %d\n",
-         nmeta, nlog, ninodeblocks, nbitmap, nblocks, FSSIZE);
+  printf("nmeta %d (boot, super, log blocks %u inode blocks %u, bitmap blocks %u, swap blocks %u) blocks %d total %d\n",
+         nmeta, nlog, ninodeblocks, nbitmap, nswapblocks, nblocks, FSSIZE);
 
   freeblock = nmeta;     // the first free block that we can allocate
 
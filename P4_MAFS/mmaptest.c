@@ -0,0 +1,168 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "param.h"
+
+// mmap 테스트
+// 1. 비공개 매핑은 파일 내용을 읽고, 매핑에 써도 파일은 그대로인지
+// 2. 공유 매핑에 쓴 내용이 munmap 뒤 read로 보이는지
+// 3. fork한 자식이 공유 매핑에 쓴 내용을 부모가 바로 보는지, fsync로 파일에 반영되는지
+// 4. write로 쓴 내용이 이미 매핑된 페이지에 보이는지
+// 5. 파일 끝을 넘는 매핑은 끝 뒤가 0이고, 거기 쓴 내용은 파일에 반영되지 않는지
+// 6. 같은 파일을 read로 읽을 때와 매핑해 읽을 때 걸리는 시간
+// 사용법: mmaptest
+
+#define PGSIZE 4096
+#define NPAGES 64
+#define FILESZ (NPAGES*PGSIZE)
+
+char buf[PGSIZE];
+
+// i번째 바이트에 들어갈 값
+int pattern(int i)
+{
+	return (i * 7 + i / PGSIZE) & 0xff;
+}
+
+int makefile(char *name)
+{
+	int fd, i, j;
+
+	unlink(name);
+	if((fd = open(name, O_CREATE|O_RDWR)) < 0)
+		return -1;
+	for(i = 0; i < NPAGES; i++) {
+		for(j = 0; j < PGSIZE; j++)
+			buf[j] = pattern(i*PGSIZE + j);
+		if(write(fd, buf, PGSIZE) != PGSIZE) {
+			close(fd);
+			return -1;
+		}
+	}
+	return fd;
+}
+
+// 파일의 off 위치 한 바이트
+int fileat(char *name, int off)
+{
+	int fd;
+	char c;
+
+	if((fd = open(name, O_RDONLY)) < 0)
+		return -1;
+	while(off >= PGSIZE) {
+		read(fd, buf, PGSIZE);
+		off -= PGSIZE;
+	}
+	read(fd, buf, off + 1);
+	c = buf[off];
+	close(fd);
+	return c & 0xff;
+}
+
+int main(void)
+{
+	struct stat st;
+	char *p;
+	int fd, i, ok, sum, msum;
+	uint start, rticks, mticks;
+
+	if((fd = makefile("mmapfile")) < 0) {
+		printf(1, "mmaptest: cannot create file\n");
+		exit();
+	}
+
+	// 1. 비공개 매핑
+	if((int)(p = mmap(fd, PGSIZE, FILESZ - PGSIZE, 0)) < 0) {
+		printf(1, "mmaptest: mmap failed\n");
+		exit();
+	}
+	ok = 1;
+	for(i = 0; i < FILESZ - PGSIZE; i++)
+		if((p[i] & 0xff) != pattern(PGSIZE + i))
+			ok = 0;
+	p[0] = 'x';
+	if(munmap(p, FILESZ - PGSIZE) < 0 || fileat("mmapfile", PGSIZE) != pattern(PGSIZE))
+		ok = 0;
+	printf(1, "private mapping reads the file and keeps writes to itself: %s\n", ok ? "ok" : "FAILED");
+
+	// 2. 공유 매핑
+	if((int)(p = mmap(fd, 0, FILESZ, MAP_SHARED)) < 0) {
+		printf(1, "mmaptest: shared mmap failed\n");
+		exit();
+	}
+	p[5] = 'y';
+	p[3*PGSIZE + 1] = 'z';
+	ok = munmap(p, FILESZ) == 0 && fileat("mmapfile", 5) == 'y' && fileat("mmapfile", 3*PGSIZE + 1) == 'z';
+	printf(1, "shared mapping is written back at munmap: %s\n", ok ? "ok" : "FAILED");
+
+	// 3. fork한 자식과 공유
+	if((int)(p = mmap(fd, 0, FILESZ, MAP_SHARED)) < 0) {
+		printf(1, "mmaptest: shared mmap failed\n");
+		exit();
+	}
+	p[PGSIZE] = 0;
+	if(fork() == 0) {
+		p[PGSIZE] = 'c';
+		p[2*PGSIZE] = 'd'; // 부모가 아직 건드리지 않은 페이지
+		exit();
+	}
+	wait();
+	ok = p[PGSIZE] == 'c' && p[2*PGSIZE] == 'd';
+	fsync(fd);
+	ok = ok && fileat("mmapfile", PGSIZE) == 'c';
+	printf(1, "child's writes are seen by the parent and fsync writes them: %s\n", ok ? "ok" : "FAILED");
+
+	// 4. write가 매핑에 보임
+	buf[0] = 'w';
+	close(fd);
+	fd = open("mmapfile", O_RDWR); // 오프셋 0부터 씀
+	write(fd, buf, 1);
+	ok = p[0] == 'w';
+	printf(1, "write() is visible through the mapping: %s\n", ok ? "ok" : "FAILED");
+	munmap(p, FILESZ);
+
+	printf(1, "bad arguments rejected: %s\n",
+		(int)mmap(fd, 1, PGSIZE, 0) < 0 && (int)mmap(fd, 0, 0, 0) < 0 &&
+		(int)mmap(fd, FILESZ + PGSIZE, PGSIZE, 0) < 0 && // 파일 끝 뒤
+		(int)mmap(fd, PGSIZE, 0x7ffff000, 0) < 0 && // 오버플로
+		munmap(p, FILESZ) < 0 ? "ok" : "FAILED"); // 이미 없앤 매핑
+
+	// 5. 파일 끝을 넘는 매핑
+	if((int)(p = mmap(fd, 0, FILESZ + 2*PGSIZE, MAP_SHARED)) < 0) {
+		printf(1, "mmaptest: mmap past EOF failed\n");
+		exit();
+	}
+	ok = p[FILESZ - 1] == (char)pattern(FILESZ - 1);
+	for(i = FILESZ; i < FILESZ + 2*PGSIZE; i += 512)
+		if(p[i] != 0)
+			ok = 0;
+	p[FILESZ] = 'e';
+	munmap(p, FILESZ + 2*PGSIZE);
+	ok = ok && fstat(fd, &st) == 0 && st.size == FILESZ && fileat("mmapfile", FILESZ - 1) == pattern(FILESZ - 1);
+	printf(1, "pages past EOF read as zero and do not grow the file: %s\n", ok ? "ok" : "FAILED");
+	close(fd);
+
+	// 6. read와 mmap으로 파일 훑기
+	fd = open("mmapfile", O_RDONLY);
+	sum = 0;
+	start = uptime();
+	for(i = 0; i < NPAGES; i++) {
+		read(fd, buf, PGSIZE);
+		sum += buf[i];
+	}
+	rticks = uptime() - start;
+	msum = 0;
+	start = uptime();
+	p = mmap(fd, 0, FILESZ, 0);
+	for(i = 0; i < NPAGES; i++)
+		msum += p[i*PGSIZE + i];
+	munmap(p, FILESZ);
+	mticks = uptime() - start;
+	printf(1, "scan of %d pages: read %d ticks, mmap %d ticks, same data: %s\n",
+		NPAGES, rticks, mticks, sum == msum ? "ok" : "FAILED");
+	close(fd);
+	unlink("mmapfile");
+	exit();
+}
@@ -10,6 +10,7 @@
 #define CR0_PG          0x80000000      // Paging
 
 #define CR4_PSE         0x00000010      // Page size extension
+#define CR4_PGE         0x00000080      // Page global enable
 
 // various segment selectors.
 #define SEG_KCODE 1  // kernel code
@@ -83,6 +84,7 @@ struct segdesc {
 #define NPDENTRIES      1024    // # directory entries per page directory
 #define NPTENTRIES      1024    // # PTEs per page table
 #define PGSIZE          4096    // bytes mapped by a page
+#define SPSIZE          (PGSIZE*NPTENTRIES) // bytes mapped by a 4MB superpage (PTE_PS)
 
 #define PTXSHIFT        12      // offset of PTX in a linear address
 #define PDXSHIFT        22      // offset of PDX in a linear address
@@ -94,7 +96,17 @@ struct segdesc {
 #define PTE_P           0x001   // Present
 #define PTE_W           0x002   // Writeable
 #define PTE_U           0x004   // User
+#define PTE_A           0x020   // Accessed
+#define PTE_D           0x040   // Dirty
 #define PTE_PS          0x080   // Page Size
+#define PTE_G           0x100   // Global (not flushed by a cr3 reload)
+#define PTE_COW         0x200   // 쓰기 시 복사할 공유 페이지 (소프트웨어 사용 비트)
+#define PTE_SWAP        0x400   // 스왑으로 나간 페이지. 주소 자리에 슬롯 번호 (소프트웨어 사용 비트)
+#define PTE_FILE        0x800   // 아직 파일(공유 메모리)에서 가져오지 않은 페이지 (소프트웨어 사용 비트)
+
+// Page fault error code bits
+#define FEC_P           0x001   // 존재하는 페이지의 보호 위반 (0이면 not present)
+#define FEC_WR          0x002   // 쓰기 접근
 
 // Address in page table or page directory entry
 #define PTE_ADDR(pte)   ((uint)(pte) & ~0xFFF)
@@ -2,13 +2,22 @@
 #define KSTACKSIZE 4096  // size of per-process kernel stack
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
-#define NFILE       100  // open files per system
-#define NINODE       50  // maximum number of active i-nodes
+#define NINODE       50  // i-nodes kept cached when unused (more are allocated on demand)
 #define NDEV         10  // maximum major device number
 #define ROOTDEV       1  // device number of file system root disk
 #define MAXARG       32  // max exec arguments
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
-#define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
+#define NBUF         (MAXOPBLOCKS*3)  // disk blocks kept cached when unused (more on demand)
 #define FSSIZE       2500000  // size of file system in blocks
+#define MAXORDER     10   // buddy 할당기의 최대 차수. 2^10 페이지 = 4MB
+#define NSSUREGION   8    // 프로세스마다 접근 패턴을 기억하는 ssualloc 영역 수
+#define SSUFAMAX     32   // ssualloc 폴트 한 번에 매핑하는 최대 페이지 수(fault-around)
+#define SSU_POPULATE 1    // ssualloc flag: 모든 페이지를 미리 할당
+#define NSWAPSLOT    131072 // mkfs가 예약하는 스왑 슬롯(페이지) 수. 512MB
+#define SWAPLOW      256  // 빈 페이지가 이보다 적으면 사용자 페이지를 할당하기 전에 스왑으로 내보냄
+#define NVMA         8    // 프로세스마다 파일을 매핑할 수 있는 구간 수
+#define NPCACHE      4096 // page cache가 보관하는 파일 페이지 수. 모두 매핑 중이면 더 늘어남
+#define MAP_SHARED   1    // mmap flag: 매핑에 쓴 내용을 파일에 반영하고 fork한 자식과 공유
+#define NSHM         16   // 공유 메모리 세그먼트 수
 
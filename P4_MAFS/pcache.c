@@ -0,0 +1,216 @@
+// Page cache.
+// 파일의 한 페이지(오프셋 off부터 PGSIZE 바이트)를 담은 물리 페이지를 (dev, inum, off)로
+// 찾을 수 있게 보관한다. 캐시가 페이지 참조를 하나 잡고 있고, 페이지를 매핑한 PTE마다
+// 참조가 하나씩 늘어남(kref). 그래서 krefcnt가 1인 페이지는 아무도 매핑하지 않은 것이라
+// 언제든 버릴 수 있음. exec가 매핑하는 세그먼트는 페이지 정렬되지 않은 오프셋에서 시작하므로
+// off는 임의의 바이트 오프셋.
+// 항목은 slab에서 필요할 때 할당. NPCACHE개까지는 그냥 늘리고, 그 뒤로는 매핑되지 않은 페이지를
+// 먼저 버리되 버릴 페이지가 없으면(모두 매핑 중이면) 더 늘림. 그래서 메모리가 있는 한 pcache_get은
+// 실패하지 않음.
+// writei가 쓴 내용은 겹치는 캐시 페이지에도 바로 반영되고, itrunc는 그 파일의 페이지를 모두 버림.
+// 캐시는 inode 참조를 잡지 않으므로 inode 번호가 재사용되기 전에 반드시 itrunc를 거침
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
+
+#define NPCHASH 1021
+
+struct pcpage {
+  uint dev, inum, off;
+  char *page;
+  struct pcpage *next;    // 같은 해시 버킷의 다음 항목
+  struct pcpage *lnext;   // 모든 항목의 목록
+  struct pcpage *lprev;
+};
+
+struct {
+  struct spinlock lock;
+  struct kmem_cache *cache;
+  int npage;              // 현재 항목 수
+  struct pcpage *hash[NPCHASH];
+  struct pcpage head;     // 모든 항목의 목록
+  struct pcpage *hand;    // 버릴 페이지를 찾는 clock 바늘. 목록 안의 위치
+} pcache;
+
+void
+pcacheinit(void)
+{
+  initlock(&pcache.lock, "pcache");
+  pcache.cache = kmem_cache_create("pcpage", sizeof(struct pcpage));
+  pcache.head.lnext = &pcache.head;
+  pcache.head.lprev = &pcache.head;
+  pcache.hand = &pcache.head;
+}
+
+static struct pcpage**
+bucket(uint dev, uint inum, uint off)
+{
+  return &pcache.hash[(dev*31 + inum*17 + off/PGSIZE) % NPCHASH];
+}
+
+static struct pcpage*
+lookup(uint dev, uint inum, uint off)
+{
+  struct pcpage *c;
+
+  for(c = *bucket(dev, inum, off); c; c = c->next)
+    if(c->dev == dev && c->inum == inum && c->off == off)
+      return c;
+  return 0;
+}
+
+// 항목 c를 해시와 목록에서 빼고 페이지 참조와 항목을 반환. pcache.lock을 잡고 불러야 함
+static void
+drop(struct pcpage *c)
+{
+  struct pcpage **pp;
+
+  for(pp = bucket(c->dev, c->inum, c->off); *pp != c; pp = &(*pp)->next)
+    ;
+  *pp = c->next;
+  if(pcache.hand == c)
+    pcache.hand = c->lprev;
+  c->lprev->lnext = c->lnext;
+  c->lnext->lprev = c->lprev;
+  pcache.npage--;
+  kfree(c->page);
+  kmem_cache_free(pcache.cache, c);
+}
+
+// clock 바늘을 돌며 아무도 매핑하지 않은 페이지 하나를 버림. 없으면 -1.
+// pcache.lock을 잡고 불러야 함
+static int
+evict(void)
+{
+  struct pcpage *c;
+  int i;
+
+  for(i = 0; i <= pcache.npage; i++){
+    c = pcache.hand = pcache.hand->lnext;
+    if(c != &pcache.head && krefcnt(c->page) == 1){
+      drop(c);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+// 파일 ip의 오프셋 off부터 한 페이지를 담은 캐시 페이지를 참조를 하나 늘려 반환.
+// 캐시에 없으면 디스크에서 읽어 넣음. 파일 끝 뒤는 0. 잠들 수 있어야 하고 ip를 잠그지
+// 않은 채로 불러야 함. 메모리가 없거나 파일을 읽지 못하면 0
+char*
+pcache_get(struct inode *ip, uint off)
+{
+  struct pcpage *c;
+  char *mem;
+  int n;
+
+  acquire(&pcache.lock);
+  if((c = lookup(ip->dev, ip->inum, off)) != 0){
+    kref(c->page);
+    release(&pcache.lock);
+    return c->page;
+  }
+  release(&pcache.lock);
+
+  if((mem = kalloc()) == 0 && (pcache_shrink() < 0 || (mem = kalloc()) == 0))
+    return 0;
+  // 넣을 때까지 ip를 잠가 두어 그 사이의 writei가 pcache_update를 놓치지 않게 함
+  ilock(ip);
+  if((n = readi(ip, mem, off, PGSIZE)) < 0){
+    iunlock(ip);
+    kfree(mem);
+    return 0;
+  }
+  memset(mem + n, 0, PGSIZE - n);
+
+  acquire(&pcache.lock);
+  if((c = lookup(ip->dev, ip->inum, off)) != 0){ // 읽는 동안 다른 프로세스가 넣음
+    kref(c->page);
+    release(&pcache.lock);
+    iunlock(ip);
+    kfree(mem);
+    return c->page;
+  }
+  // NPCACHE개를 넘으면 한 페이지를 버려 자리를 만들고, 모두 매핑 중이면 그냥 늘림
+  if(pcache.npage >= NPCACHE)
+    evict();
+  if((c = kmem_cache_alloc(pcache.cache)) == 0){
+    release(&pcache.lock);
+    iunlock(ip);
+    kfree(mem);
+    return 0;
+  }
+  c->dev = ip->dev;
+  c->inum = ip->inum;
+  c->off = off;
+  c->page = mem;
+  c->next = *bucket(c->dev, c->inum, c->off);
+  *bucket(c->dev, c->inum, c->off) = c;
+  c->lnext = pcache.head.lnext;
+  c->lprev = &pcache.head;
+  pcache.head.lnext->lprev = c;
+  pcache.head.lnext = c;
+  pcache.npage++;
+  kref(mem); // 캐시와 호출한 쪽이 하나씩
+  release(&pcache.lock);
+  iunlock(ip);
+  return mem;
+}
+
+// writei가 파일 ip의 [off, off+n)에 src를 썼음. 겹치는 캐시 페이지에도 반영.
+// 겹치는 페이지의 오프셋은 (off-PGSIZE, off+n) 안에 있으므로 그 페이지 번호들의 해시
+// 버킷만 살펴봄
+void
+pcache_update(struct inode *ip, uint off, char *src, uint n)
+{
+  struct pcpage *c;
+  uint i, s, e;
+
+  acquire(&pcache.lock);
+  for(i = off < PGSIZE ? 0 : (off - PGSIZE + 1) / PGSIZE; i <= (off + n - 1) / PGSIZE; i++){
+    for(c = *bucket(ip->dev, ip->inum, i * PGSIZE); c; c = c->next){
+      if(c->dev != ip->dev || c->inum != ip->inum)
+        continue;
+      if(off >= c->off + PGSIZE || off + n <= c->off)
+        continue;
+      s = off > c->off ? off : c->off;
+      e = off + n < c->off + PGSIZE ? off + n : c->off + PGSIZE;
+      memmove(c->page + (s - c->off), src + (s - off), e - s);
+    }
+  }
+  release(&pcache.lock);
+}
+
+// 파일 ip의 캐시 페이지를 모두 버림. 파일을 잘라낼 때(itrunc) 부름
+void
+pcache_inval(struct inode *ip)
+{
+  struct pcpage *c, *next;
+
+  acquire(&pcache.lock);
+  for(c = pcache.head.lnext; c != &pcache.head; c = next){
+    next = c->lnext;
+    if(c->dev == ip->dev && c->inum == ip->inum)
+      drop(c);
+  }
+  release(&pcache.lock);
+}
+
+// 아무도 매핑하지 않은 캐시 페이지 하나를 반환. 없으면 -1
+int
+pcache_shrink(void)
+{
+  int r;
+
+  acquire(&pcache.lock);
+  r = evict();
+  release(&pcache.lock);
+  return r;
+}
@@ -88,6 +88,10 @@ allocproc(void)
 found:
   p->state = EMBRYO;
   p->pid = nextpid++;
+  p->nssureg = 0;
+  p->nfault = 0;
+  p->swaphand = 0;
+  memset(p->vma, 0, sizeof(p->vma));
 
   release(&ptable.lock);
 
@@ -169,8 +173,7 @@ growproc(int n)
     if((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
       return -1;
   }
-  curproc->sz = sz;
-  switchuvm(curproc);
+  curproc->sz = sz; // 줄어든 범위의 TLB 항목은 deallocuvm이 지움
   return 0;
 }
 
@@ -190,13 +193,16 @@ fork(void)
   }
 
   // Copy process state from proc.
-  if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
+  if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz, curproc->vma)) == 0){
     kfree(np->kstack);
     np->kstack = 0;
     np->state = UNUSED;
     return -1;
   }
   np->sz = curproc->sz;
+  np->nssureg = curproc->nssureg;
+  memmove(np->ssureg, curproc->ssureg, sizeof(np->ssureg));
+  vma_dup(np->vma, curproc->vma);
   np->parent = curproc;
   *np->tf = *curproc->tf;
 
@@ -246,6 +252,7 @@ exit(void)
   iput(curproc->cwd);
   end_op();
   curproc->cwd = 0;
+  vma_release(curproc->vma, curproc->pgdir);
 
   acquire(&ptable.lock);
 
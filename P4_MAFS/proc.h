@@ -49,6 +49,23 @@ struct proc {
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
   char name[16];               // Process name (debugging)
+
+  struct ssuregion {           // ssualloc 한 번으로 예약한 영역의 접근 패턴
+    uint start, end;           // 영역의 가상 주소 [start, end)
+    uint next;                 // 순차 접근이라면 다음 폴트가 날 주소
+    uint win;                  // 마지막 폴트에서 매핑한 페이지 수
+  } ssureg[NSSUREGION];
+  int nssureg;                 // 사용 중인 ssureg 수
+  uint nfault;                 // 처리한 페이지 폴트 수
+  uint swaphand;               // 스왑 clock 바늘. 다음에 살펴볼 가상 주소
+  struct vma {                 // 파일이나 공유 메모리를 매핑한 구간. PTE_FILE 페이지는 처음 접근할 때 가져옴
+    uint start, end;           // 가상 주소 [start, end). start는 페이지 정렬
+    struct inode *ip;          // 매핑한 파일. ip와 shm이 모두 0이면 빈 항목
+    struct shm *shm;           // 매핑한 공유 메모리 세그먼트
+    uint off;                  // start에 대응하는 파일(세그먼트) 오프셋
+    uint filesz;               // start부터 파일에서 읽을 바이트 수. 나머지는 0으로 채움
+    int flags;                 // MAP_SHARED
+  } vma[NVMA];
 };
 
 // Process memory is laid out contiguously, low addresses first:
@@ -0,0 +1,91 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+
+// ssurelease 테스트
+// 1. 다 쓴 ssualloc 영역의 일부를 반환하면 물리 페이지 수가 줄고 가상 페이지 수는 그대로인지
+// 2. 반환한 페이지를 다시 읽으면 0이고, 다시 쓸 수 있는지. 반환하지 않은 페이지는 그대로인지
+// 3. 잘못된 인자는 거절하는지
+// 4. sbrk로 늘렸다 줄이기를 반복해도 페이지 테이블 페이지가 쌓이지 않는지
+// 5. 공유 메모리나 프로그램처럼 매핑된 구간은 거절하고 내용과 공유가 그대로인지
+
+#define PGSIZE 4096
+#define NPAGES 256
+#define NROUND 20
+#define GROW (8*1024*1024)
+
+int freepages(void)
+{
+	int nfree[MAXORDER+2];
+	int k, total = 0;
+
+	kmemstat(nfree);
+	for(k = 0; k <= MAXORDER; k++)
+		total += nfree[k] << k;
+	return total + nfree[MAXORDER+1];
+}
+
+int main(void)
+{
+	char *addr, *shm;
+	int i, ok, before;
+
+	addr = (char*)ssualloc(NPAGES*PGSIZE, 0);
+	if((int)addr < 0) {
+		printf(1, "releasetest: ssualloc failed\n");
+		exit();
+	}
+	for(i = 0; i < NPAGES; i++)
+		addr[i*PGSIZE] = 'a';
+	printf(1, "after writing %d pages: virtual pages %d, physical pages %d\n", NPAGES, getvp(), getpp());
+
+	if(ssurelease(addr, NPAGES/2*PGSIZE) < 0) {
+		printf(1, "releasetest: ssurelease failed\n");
+		exit();
+	}
+	printf(1, "after releasing %d pages: virtual pages %d, physical pages %d\n", NPAGES/2, getvp(), getpp());
+
+	ok = 1;
+	for(i = 0; i < NPAGES; i++)
+		if(addr[i*PGSIZE] != (i < NPAGES/2 ? 0 : 'a'))
+			ok = 0;
+	for(i = 0; i < NPAGES/2; i++)
+		addr[i*PGSIZE] = 'b';
+	for(i = 0; i < NPAGES/2; i++)
+		if(addr[i*PGSIZE] != 'b')
+			ok = 0;
+	printf(1, "released pages read as zero and are writable again: %s\n", ok ? "ok" : "FAILED");
+
+	printf(1, "bad arguments rejected: %s\n",
+		ssurelease(addr + 1, PGSIZE) < 0 && ssurelease(addr, 100) < 0 &&
+		ssurelease(addr, 0) < 0 && ssurelease(sbrk(0), PGSIZE) < 0 ? "ok" : "FAILED");
+
+	before = freepages();
+	for(i = 0; i < NROUND; i++) {
+		if(sbrk(GROW) == (char*)-1) {
+			printf(1, "releasetest: sbrk failed\n");
+			exit();
+		}
+		sbrk(-GROW);
+	}
+	printf(1, "free pages after %d sbrk grow/shrink rounds: %d -> %d\n", NROUND, before, freepages());
+
+	if((int)(shm = shmmap(0, 4*PGSIZE)) < 0) {
+		printf(1, "releasetest: shmmap failed\n");
+		exit();
+	}
+	for(i = 0; i < 4; i++)
+		shm[i*PGSIZE] = 's';
+	ok = ssurelease(shm, 4*PGSIZE) < 0 && ssurelease(shm + PGSIZE, PGSIZE) < 0 &&
+		ssurelease((char*)0, PGSIZE) < 0; // 프로그램 구간
+	if(fork() == 0) { // 공유가 끊기지 않았다면 부모가 자식이 쓴 내용을 봄
+		shm[PGSIZE] = 't';
+		exit();
+	}
+	wait();
+	ok = ok && shm[0] == 's' && shm[PGSIZE] == 't';
+	printf(1, "mapped ranges rejected and still shared: %s\n", ok ? "ok" : "FAILED");
+	munmap(shm, 4*PGSIZE);
+	exit();
+}
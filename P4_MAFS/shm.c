@@ -0,0 +1,135 @@
+// Shared memory segments.
+// 세그먼트는 물리 페이지 배열이고, 페이지는 처음 폴트가 날 때 vm.c가 할당해 넣는다.
+// 세그먼트가 페이지마다 참조를 하나 잡고 매핑한 PTE마다 하나씩 늘어남(kref).
+// key가 0이 아닌 세그먼트는 같은 key로 shmmap한 프로세스끼리, key가 0인 세그먼트는
+// fork로 매핑을 물려받은 프로세스끼리 공유함. 세그먼트를 매핑한 vma가 모두 사라지면 반환
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "spinlock.h"
+
+#define SHMMAXPG (PGSIZE / sizeof(char*))  // 세그먼트 하나의 최대 페이지 수. 페이지 표가 한 페이지
+
+struct shm {
+  int key;
+  int ref;                // 세그먼트를 매핑한 vma 수. 0이면 빈 항목
+  uint npages;
+  char **pages;           // 페이지 표. 아직 할당하지 않은 페이지는 0
+};
+
+struct {
+  struct spinlock lock;
+  struct shm seg[NSHM];
+} shm;
+
+void
+shminit(void)
+{
+  initlock(&shm.lock, "shm");
+}
+
+// 키 key의 세그먼트를 참조를 하나 늘려 반환. 없거나 key가 0이면 npages 페이지짜리로 새로 만듦.
+// 이미 있는 세그먼트가 npages보다 작거나 빈 항목, 메모리가 없으면 0
+struct shm*
+shm_get(int key, uint npages)
+{
+  struct shm *s, *free;
+  char **pages;
+
+  if(npages == 0 || npages > SHMMAXPG)
+    return 0;
+  if((pages = (char**)kalloc()) == 0)
+    return 0;
+  memset(pages, 0, PGSIZE);
+
+  acquire(&shm.lock);
+  free = 0;
+  for(s = shm.seg; s < &shm.seg[NSHM]; s++){
+    if(s->ref == 0){
+      if(free == 0)
+        free = s;
+      continue;
+    }
+    if(key != 0 && s->key == key){
+      if(s->npages < npages){
+        release(&shm.lock);
+        kfree((char*)pages);
+        return 0;
+      }
+      s->ref++;
+      release(&shm.lock);
+      kfree((char*)pages);
+      return s;
+    }
+  }
+  if(free == 0){
+    release(&shm.lock);
+    kfree((char*)pages);
+    return 0;
+  }
+  free->key = key;
+  free->ref = 1;
+  free->npages = npages;
+  free->pages = pages;
+  release(&shm.lock);
+  return free;
+}
+
+void
+shm_dup(struct shm *s)
+{
+  acquire(&shm.lock);
+  if(s->ref <= 0)
+    panic("shm_dup");
+  s->ref++;
+  release(&shm.lock);
+}
+
+// 참조를 하나 놓음. 마지막 참조면 세그먼트의 페이지와 페이지 표를 반환
+void
+shm_put(struct shm *s)
+{
+  char **pages;
+  uint i, n;
+
+  acquire(&shm.lock);
+  if(s->ref <= 0)
+    panic("shm_put");
+  if(--s->ref > 0){
+    release(&shm.lock);
+    return;
+  }
+  pages = s->pages;
+  n = s->npages;
+  s->pages = 0;
+  release(&shm.lock);
+
+  for(i = 0; i < n; i++)
+    if(pages[i])
+      kfree(pages[i]);
+  kfree((char*)pages);
+}
+
+// 세그먼트 s의 i번째 페이지를 참조를 하나 늘려 반환. 아직 없으면 mem(0으로 채운 새 페이지)을
+// 넣어서 반환하고, mem이 0이면 0. 이미 있는데 mem을 받았으면 mem은 반환
+char*
+shm_page(struct shm *s, uint i, char *mem)
+{
+  char *v;
+
+  if(i >= s->npages)
+    panic("shm_page");
+  acquire(&shm.lock);
+  if((v = s->pages[i]) == 0 && mem){
+    v = s->pages[i] = mem; // 세그먼트의 참조
+    mem = 0;
+  }
+  if(v)
+    kref(v); // 매핑할 PTE의 참조
+  release(&shm.lock);
+  if(mem)
+    kfree(mem);
+  return v;
+}
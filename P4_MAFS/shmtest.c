@@ -0,0 +1,117 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+
+// 공유 메모리 테스트
+// 1. key 0 세그먼트에 fork한 자식이 쓴 내용을 부모가 보는지
+// 2. 같은 key로 따로 매핑한 두 프로세스가 같은 페이지를 보는지
+// 3. 마지막 매핑이 사라지면 세그먼트의 페이지가 반환되는지
+// 4. NBYTES를 pipe로 보낼 때와 공유 메모리로 넘길 때 걸리는 시간
+// 사용법: shmtest
+
+#define PGSIZE 4096
+#define NPAGES 16
+#define SHMKEY 77
+#define NBYTES (4*1024*1024)
+#define CHUNK 512
+
+char buf[CHUNK];
+
+int freepages(void)
+{
+	int nfree[MAXORDER+2];
+	int k, total = 0;
+
+	kmemstat(nfree);
+	for(k = 0; k <= MAXORDER; k++)
+		total += nfree[k] << k;
+	return total + nfree[MAXORDER+1];
+}
+
+int main(void)
+{
+	char *p, *q;
+	int fd[2], i, n, ok, before;
+	uint start, pticks, sticks;
+	char c;
+
+	// 1. fork로 물려받은 세그먼트
+	if((int)(p = shmmap(0, NPAGES*PGSIZE)) < 0) {
+		printf(1, "shmtest: shmmap failed\n");
+		exit();
+	}
+	if(fork() == 0) {
+		for(i = 0; i < NPAGES; i++)
+			p[i*PGSIZE] = 'a' + i;
+		exit();
+	}
+	wait();
+	ok = 1;
+	for(i = 0; i < NPAGES; i++)
+		if(p[i*PGSIZE] != 'a' + i)
+			ok = 0;
+	printf(1, "parent sees the child's writes: %s\n", ok ? "ok" : "FAILED");
+	munmap(p, NPAGES*PGSIZE);
+
+	// 2. key로 찾은 세그먼트. 부모가 먼저 만들고 자식은 fork 뒤에 따로 매핑
+	pipe(fd);
+	p = shmmap(SHMKEY, PGSIZE);
+	if(fork() == 0) {
+		q = shmmap(SHMKEY, PGSIZE);
+		read(fd[0], &c, 1); // 부모가 쓸 때까지
+		q[PGSIZE-1] = q[0] + 1;
+		exit();
+	}
+	p[0] = 'k';
+	write(fd[1], &c, 1);
+	wait();
+	printf(1, "two mappings of key %d share pages: %s\n", SHMKEY, p[PGSIZE-1] == 'k' + 1 ? "ok" : "FAILED");
+	munmap(p, PGSIZE);
+
+	// 3. 반환
+	before = freepages();
+	p = shmmap(0, NPAGES*PGSIZE);
+	for(i = 0; i < NPAGES; i++)
+		p[i*PGSIZE] = 1;
+	n = before - freepages();
+	munmap(p, NPAGES*PGSIZE);
+	printf(1, "segment used %d pages, %d left after munmap\n", n, before - freepages());
+
+	// 4. pipe와 공유 메모리로 NBYTES 넘기기. 공유 메모리는 다 채웠다는 신호만 pipe로 보냄
+	start = uptime();
+	if(fork() == 0) {
+		close(fd[0]);
+		for(i = 0; i < NBYTES; i += CHUNK)
+			write(fd[1], buf, CHUNK);
+		exit();
+	}
+	close(fd[1]);
+	for(i = 0; i < NBYTES; i += n)
+		if((n = read(fd[0], buf, CHUNK)) <= 0)
+			break;
+	wait();
+	close(fd[0]);
+	pticks = uptime() - start;
+
+	pipe(fd);
+	start = uptime();
+	p = shmmap(0, NBYTES);
+	if(fork() == 0) {
+		for(i = 0; i < NBYTES; i += PGSIZE)
+			memset(p + i, i / PGSIZE, PGSIZE);
+		write(fd[1], &c, 1);
+		exit();
+	}
+	read(fd[0], &c, 1);
+	ok = 1;
+	for(i = 0; i < NBYTES; i += PGSIZE)
+		if(p[i + PGSIZE/2] != (char)(i / PGSIZE))
+			ok = 0;
+	wait();
+	munmap(p, NBYTES);
+	sticks = uptime() - start;
+	printf(1, "%d bytes: pipe %d ticks, shared memory %d ticks, data ok: %s\n",
+		NBYTES, pticks, sticks, ok ? "ok" : "FAILED");
+	exit();
+}
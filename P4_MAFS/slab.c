@@ -0,0 +1,188 @@
+// Slab allocator for small kernel objects.
+// 같은 크기의 객체들을 kalloc 페이지(slab) 하나에 모아 담는다. 페이지 맨 앞에 slab 헤더가
+// 있으므로 객체 주소를 페이지 단위로 내리면 자신의 slab을 찾을 수 있음.
+// 빈 객체가 남은 slab만 cache->partial 목록에 두고, 가득 찬 slab은 어느 목록에도 없다.
+// 각 CPU는 캐시마다 최대 SLABMAG개의 객체를 보관해 대부분의 할당/반환은 잠금 없이 끝남.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "spinlock.h"
+
+#define NKMEMCACHE 8   // 만들 수 있는 캐시 수
+#define SLABMAG    8   // CPU마다 캐시별로 보관하는 객체 수
+
+struct slab {
+  struct kmem_cache *cache;
+  struct slab *next;     // cache->partial 목록
+  struct slab *prev;
+  void *freelist;        // 빈 객체 목록. 각 객체의 첫 워드가 다음 빈 객체
+  int inuse;             // 할당된 객체 수
+};
+
+struct kmem_cache {
+  char *name;
+  uint size;             // 객체 크기. 4바이트 단위로 올림
+  int perslab;           // slab 하나에 들어가는 객체 수
+  struct spinlock lock;  // partial, nslab과 slab 내부를 보호
+  struct slab *partial;  // 빈 객체가 있는 slab 목록
+  int nslab;             // 이 캐시가 가진 페이지 수
+  struct {
+    void *obj[SLABMAG];
+    int n;
+  } mag[NCPU];           // CPU별 객체 캐시. 인터럽트를 끄고 자신의 것만 씀
+};
+
+static struct {
+  struct spinlock lock;
+  struct kmem_cache cache[NKMEMCACHE];
+  int ncache;
+} slabtable;
+
+void
+slabinit(void)
+{
+  initlock(&slabtable.lock, "slabtable");
+}
+
+// size 바이트 객체의 캐시를 만듦. 객체는 slab 헤더를 뺀 한 페이지에 들어가야 함
+struct kmem_cache*
+kmem_cache_create(char *name, uint size)
+{
+  struct kmem_cache *c;
+
+  size = (size + 3) & ~3;
+  if(size < sizeof(void*) || size > PGSIZE - sizeof(struct slab))
+    panic("kmem_cache_create: size");
+  acquire(&slabtable.lock);
+  if(slabtable.ncache == NKMEMCACHE)
+    panic("kmem_cache_create: too many caches");
+  c = &slabtable.cache[slabtable.ncache++];
+  release(&slabtable.lock);
+
+  c->name = name;
+  c->size = size;
+  c->perslab = (PGSIZE - sizeof(struct slab)) / size;
+  initlock(&c->lock, name);
+  return c;
+}
+
+static void
+partial_insert(struct kmem_cache *c, struct slab *s)
+{
+  s->prev = 0;
+  s->next = c->partial;
+  if(s->next)
+    s->next->prev = s;
+  c->partial = s;
+}
+
+static void
+partial_remove(struct kmem_cache *c, struct slab *s)
+{
+  if(s->prev)
+    s->prev->next = s->next;
+  else
+    c->partial = s->next;
+  if(s->next)
+    s->next->prev = s->prev;
+}
+
+// 새 slab 페이지를 만들어 모든 객체를 빈 목록에 넣음. c->lock 필요
+static struct slab*
+slab_grow(struct kmem_cache *c)
+{
+  struct slab *s;
+  char *obj;
+  int i;
+
+  if((s = (struct slab*)kalloc()) == 0)
+    return 0;
+  s->cache = c;
+  s->inuse = 0;
+  s->freelist = 0;
+  obj = (char*)(s + 1);
+  for(i = 0; i < c->perslab; i++, obj += c->size){
+    *(void**)obj = s->freelist;
+    s->freelist = obj;
+  }
+  partial_insert(c, s);
+  c->nslab++;
+  return s;
+}
+
+// slab에서 객체 하나를 꺼냄. c->lock 필요
+static void*
+slab_get(struct kmem_cache *c)
+{
+  struct slab *s;
+  void *obj;
+
+  if((s = c->partial) == 0 && (s = slab_grow(c)) == 0)
+    return 0;
+  obj = s->freelist;
+  s->freelist = *(void**)obj;
+  if(++s->inuse == c->perslab) // 가득 참
+    partial_remove(c, s);
+  return obj;
+}
+
+// 객체를 자신의 slab에 돌려줌. 비게 된 slab은 다른 partial slab이 있다면 페이지를 반환.
+// c->lock 필요
+static void
+slab_put(struct kmem_cache *c, void *obj)
+{
+  struct slab *s = (struct slab*)PGROUNDDOWN((uint)obj);
+
+  if(s->cache != c)
+    panic("kmem_cache_free: wrong cache");
+  if(s->inuse-- == c->perslab) // 가득 차 있었다면 다시 partial로
+    partial_insert(c, s);
+  *(void**)obj = s->freelist;
+  s->freelist = obj;
+  if(s->inuse == 0 && (s->prev || s->next)){
+    partial_remove(c, s);
+    c->nslab--;
+    kfree((char*)s);
+  }
+}
+
+// 객체 하나를 할당. 내용은 초기화하지 않음. 메모리가 없으면 0
+void*
+kmem_cache_alloc(struct kmem_cache *c)
+{
+  void *obj = 0;
+  int id, n;
+
+  pushcli();
+  id = cpuid();
+  if(c->mag[id].n == 0){ // 절반만 채워 반환과 할당이 번갈아 와도 잠금을 덜 잡게 함
+    acquire(&c->lock);
+    for(n = 0; n < SLABMAG/2 && (obj = slab_get(c)) != 0; n++)
+      c->mag[id].obj[c->mag[id].n++] = obj;
+    release(&c->lock);
+  }
+  if(c->mag[id].n > 0)
+    obj = c->mag[id].obj[--c->mag[id].n];
+  popcli();
+  return obj;
+}
+
+void
+kmem_cache_free(struct kmem_cache *c, void *obj)
+{
+  int id, n;
+
+  pushcli();
+  id = cpuid();
+  if(c->mag[id].n == SLABMAG){ // 절반을 slab으로 돌려줌
+    acquire(&c->lock);
+    for(n = 0; n < SLABMAG/2; n++)
+      slab_put(c, c->mag[id].obj[--c->mag[id].n]);
+    release(&c->lock);
+  }
+  c->mag[id].obj[c->mag[id].n++] = obj;
+  popcli();
+}
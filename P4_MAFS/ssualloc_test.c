@@ -2,26 +2,66 @@
 #include "stat.h"
 #include "user.h"
 #include "fcntl.h"
+#include "param.h"
 
-int main(void)
+#define PGSIZE 4096
+#define TPAGES 4096	// 시간 측정 모드에서 쓰는 영역 크기. 16MB
+
+// 시간 측정 모드. TPAGES 페이지를 ssualloc으로 받아 한 페이지에 한 번씩 쓰고
+// 처리한 페이지 폴트 수와 걸린 시간(tick)을 출력.
+// reverse: 역순으로 씀. 순차 접근이 아니므로 폴트마다 한 페이지씩 할당
+// forward: 순서대로 씀. fault-around 창이 SSUFAMAX까지 커짐
+// populate: SSU_POPULATE로 미리 할당 받은 뒤 씀
+void sweep(char *name, int flags, int reverse)
+{
+	char *addr;
+	int i, pf;
+	uint start;
+
+	if(fork() != 0) { // 측정마다 새 프로세스를 사용해 메모리를 돌려받음
+		wait();
+		return;
+	}
+	start = uptime();
+	pf = getpf();
+	addr = (char*)ssualloc(TPAGES*PGSIZE, flags);
+	if((int)addr < 0) {
+		printf(1, "%s: ssualloc failed\n", name);
+		exit();
+	}
+	for(i = 0; i < TPAGES; i++)
+		addr[(reverse ? TPAGES-1-i : i)*PGSIZE] = 'x';
+	printf(1, "%s: %d pages, %d faults, %d ticks\n", name, TPAGES, getpf() - pf, uptime() - start);
+	exit();
+}
+
+int main(int argc, char *argv[])
 {
 	int ret;
+
+	if(argc > 1 && strcmp(argv[1], "time") == 0) {
+		sweep("reverse", 0, 1);
+		sweep("forward", 0, 0);
+		sweep("populate", SSU_POPULATE, 0);
+		exit();
+	}
+
 	printf(1, "Start: memory usages: virtual pages: %d, physical pages: %d\n", getvp(), getpp());
-	ret = ssualloc(-1234);
+	ret = ssualloc(-1234, 0);
 
 	if(ret < 0) 
 		printf(1, "ssualloc() usage: argument wrong...\n");
 	else
 		exit();
   	
-	ret = ssualloc(1234);
+	ret = ssualloc(1234, 0);
 
 	if(ret < 0)
 		printf(1, "ssualloc() usage: argument wrong...\n");
 	else
 		exit();
 
-	ret = ssualloc(4096);
+	ret = ssualloc(4096, 0);
 
 	if(ret < 0 )
 		printf(1, "ssualloc(): failed...\n");
@@ -33,7 +73,7 @@ int main(void)
 		printf(1, "After access one virtual page: virtual pages: %d, physical pages: %d\n", getvp(), getpp());
 	}
 
-	ret = ssualloc(12288);
+	ret = ssualloc(12288, 0);
 
 	if(ret < 0 )
 		printf(1, "ssualloc(): failed...\n");
@@ -0,0 +1,133 @@
+// Swap space on the root disk.
+// mkfs가 디스크 맨 끝에 sb.nswap개의 페이지 크기 슬롯을 예약한다. 슬롯 s는
+// 디스크 블록 sb.swapstart + s*SWAPBPP부터 SWAPBPP개의 블록. 슬롯마다 그 슬롯을 가리키는
+// PTE 수를 세므로 fork로 공유된 스왑 PTE도 마지막 참조가 사라질 때 슬롯이 반환됨.
+// 어떤 페이지를 내보낼지는 vm.c의 swap_out이 정함
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+
+#define SWAPBPP (PGSIZE/BSIZE)  // 슬롯 하나의 블록 수
+
+extern struct superblock sb;    // iinit이 읽기 전에는 nswap == 0이라 스왑을 쓰지 않음
+
+struct {
+  struct spinlock lock;
+  uchar ref[NSWAPSLOT];   // 슬롯을 가리키는 PTE 수. 0이면 빈 슬롯
+  uint hint;              // 다음에 빈 슬롯을 찾기 시작할 위치
+  uint nused;             // 사용 중인 슬롯 수
+  uint nout;              // 내보낸 페이지 수
+  uint nin;               // 읽어 들인 페이지 수
+} swap;
+
+void
+swapinit(void)
+{
+  initlock(&swap.lock, "swap");
+}
+
+static uint
+nslot(void)
+{
+  return sb.nswap < NSWAPSLOT ? sb.nswap : NSWAPSLOT;
+}
+
+// 빈 슬롯 하나를 참조 수 1로 할당. 없으면 -1
+int
+swap_alloc(void)
+{
+  uint i, n, s;
+
+  acquire(&swap.lock);
+  n = nslot();
+  for(i = 0; i < n; i++){
+    s = (swap.hint + i) % n;
+    if(swap.ref[s] == 0){
+      swap.ref[s] = 1;
+      swap.hint = s + 1;
+      swap.nused++;
+      release(&swap.lock);
+      return s;
+    }
+  }
+  release(&swap.lock);
+  return -1;
+}
+
+// fork로 스왑 PTE가 복사될 때 참조를 하나 늘림
+void
+swap_dup(int s)
+{
+  acquire(&swap.lock);
+  if(swap.ref[s] == 0 || swap.ref[s] == 255)
+    panic("swap_dup");
+  swap.ref[s]++;
+  release(&swap.lock);
+}
+
+void
+swap_free(int s)
+{
+  acquire(&swap.lock);
+  if(swap.ref[s] == 0)
+    panic("swap_free");
+  if(--swap.ref[s] == 0){
+    swap.nused--;
+    if(s < swap.hint)
+      swap.hint = s;
+  }
+  release(&swap.lock);
+}
+
+// 페이지 v를 슬롯 s에 씀. 디스크를 기다리므로 스핀락을 잡은 채로 부르면 안 됨
+void
+swap_write(int s, char *v)
+{
+  struct buf *b;
+  int i;
+
+  for(i = 0; i < SWAPBPP; i++){
+    b = bgetw(ROOTDEV, sb.swapstart + s*SWAPBPP + i);
+    memmove(b->data, v + i*BSIZE, BSIZE);
+    bwrite(b);
+    brelse(b);
+  }
+  acquire(&swap.lock);
+  swap.nout++;
+  release(&swap.lock);
+}
+
+// 슬롯 s를 페이지 v로 읽음
+void
+swap_read(int s, char *v)
+{
+  struct buf *b;
+  int i;
+
+  for(i = 0; i < SWAPBPP; i++){
+    b = bread(ROOTDEV, sb.swapstart + s*SWAPBPP + i);
+    memmove(v + i*BSIZE, b->data, BSIZE);
+    brelse(b);
+  }
+  acquire(&swap.lock);
+  swap.nin++;
+  release(&swap.lock);
+}
+
+// 스왑 통계. st[0] 전체 슬롯, st[1] 사용 중인 슬롯, st[2] 내보낸 페이지, st[3] 읽어 들인 페이지
+void
+swapstat(uint *st)
+{
+  acquire(&swap.lock);
+  st[0] = nslot();
+  st[1] = swap.nused;
+  st[2] = swap.nout;
+  st[3] = swap.nin;
+  release(&swap.lock);
+}
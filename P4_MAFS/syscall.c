@@ -65,6 +65,8 @@ argptr(int n, char **pp, int size)
     return -1;
   if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
     return -1;
+  if(vm_resident(curproc, i, size) < 0) // 스왑이나 파일에 있는 버퍼를 미리 읽어 들임
+    return -1;
   *pp = (char*)i;
   return 0;
 }
@@ -106,6 +108,14 @@ extern int sys_uptime(void);
 extern int sys_ssualloc(void);
 extern int sys_getvp(void);
 extern int sys_getpp(void);
+extern int sys_kmemstat(void);
+extern int sys_getpf(void);
+extern int sys_ssurelease(void);
+extern int sys_swapstat(void);
+extern int sys_mmap(void);
+extern int sys_munmap(void);
+extern int sys_fsync(void);
+extern int sys_shmmap(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -132,6 +142,14 @@ static int (*syscalls[])(void) = {
 [SYS_ssualloc]   sys_ssualloc,
 [SYS_getvp]   sys_getvp,
 [SYS_getpp]   sys_getpp,
+[SYS_kmemstat] sys_kmemstat,
+[SYS_getpf]   sys_getpf,
+[SYS_ssurelease] sys_ssurelease,
+[SYS_swapstat] sys_swapstat,
+[SYS_mmap]    sys_mmap,
+[SYS_munmap]  sys_munmap,
+[SYS_fsync]   sys_fsync,
+[SYS_shmmap]  sys_shmmap,
 };
 
 void
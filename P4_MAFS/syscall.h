@@ -22,4 +22,12 @@
 #define SYS_close  21
 #define SYS_ssualloc    22
 #define SYS_getvp  23
-#define SYS_getpp  24
\ No newline at end of file
+#define SYS_getpp  24
+#define SYS_kmemstat 25
+#define SYS_getpf  26
+#define SYS_ssurelease 27
+#define SYS_swapstat 28
+#define SYS_mmap   29
+#define SYS_munmap 30
+#define SYS_fsync  31
+#define SYS_shmmap 32
\ No newline at end of file
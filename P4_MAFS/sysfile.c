@@ -442,4 +442,52 @@ sys_pipe(void)
   fd[0] = fd0;
   fd[1] = fd1;
   return 0;
-}
\ No newline at end of file
+}
+// 파일 fd의 오프셋 off부터 len 바이트를 주소 공간 끝에 매핑하고 시작 주소를 반환.
+// off는 페이지 정렬이고 파일 끝을 넘으면 안 됨. 매핑이 파일 끝을 넘으면 그 뒤의 페이지는
+// 0으로 읽히는 자기만의 메모리이고 파일에 반영되지 않음. flags가 MAP_SHARED면 매핑에 쓴
+// 내용이 munmap이나 fsync 때 파일에 반영되며 쓰기로 연 파일이어야 함. 아니면
+// copy-on-write로 자기만의 복사본에 씀
+int
+sys_mmap(void)
+{
+  struct file *f;
+  int off, len, flags;
+
+  if(argfd(0, 0, &f) < 0 || argint(1, &off) < 0 || argint(2, &len) < 0 || argint(3, &flags) < 0)
+    return -1;
+  if(f->type != FD_INODE || !f->readable || off < 0 || off % PGSIZE || len <= 0)
+    return -1;
+  if(len > 0x7fffffff - off) // off+len이 int 범위를 넘음
+    return -1;
+  if((flags & ~MAP_SHARED) || ((flags & MAP_SHARED) && !f->writable))
+    return -1;
+  return vm_mmap(myproc(), f->ip, 0, off, len, flags);
+}
+
+// mmap으로 매핑한 [addr, addr+len)의 매핑을 없앰. addr은 페이지 정렬
+int
+sys_munmap(void)
+{
+  int addr, len;
+
+  if(argint(0, &addr) < 0 || argint(1, &len) < 0)
+    return -1;
+  if(addr % PGSIZE || len <= 0 || (uint)addr + len < (uint)addr)
+    return -1;
+  return vm_munmap(myproc(), addr, PGROUNDUP((uint)addr + len));
+}
+
+// 파일 fd를 공유 매핑한 구간에서 쓴 내용을 파일에 씀. 다른 쓰기는 로그가 이미 커밋함
+int
+sys_fsync(void)
+{
+  struct file *f;
+
+  if(argfd(0, 0, &f) < 0)
+    return -1;
+  if(f->type != FD_INODE)
+    return -1;
+  vm_fsync(myproc(), f->ip);
+  return 0;
+}
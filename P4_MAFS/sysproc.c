@@ -93,19 +93,21 @@ sys_uptime(void)
 int
 sys_ssualloc(void)
 {
-  int allocsz;
+  int allocsz, flags;
   uint oldsz, newsz;
   struct proc *curproc = myproc();
 
   if(argint(0, &allocsz) < 0 || allocsz <= 0 || allocsz % PGSIZE)
     return -1;
+  if(argint(1, &flags) < 0 || (flags & ~SSU_POPULATE))
+    return -1;
   
   oldsz = curproc->sz;
   newsz = oldsz + allocsz;
-  if ((newsz = vm_ssualloc(curproc->pgdir, oldsz, newsz)) < 0)
+  if (vm_ssualloc(curproc->pgdir, oldsz, newsz, flags) < 0)
     return -1;
   curproc->sz = newsz; // 할당받은 크기로 갱신
-  switchuvm(curproc);
+  ssu_addregion(curproc, oldsz, newsz); // 없던 매핑만 생기므로 TLB를 비울 필요 없음
   return oldsz; // 할당받은 메모리 시작 가상주소
 }
 
@@ -123,4 +125,72 @@ sys_getpp(void)
   pde_t *pgdir = myproc()->pgdir;
   
   return vm_getpp(pgdir);
-}
\ No newline at end of file
+}
+
+// 페이지 단위로 정렬된 [addr, addr+size)의 물리 메모리를 반환. 가상 주소는 예약된 채로
+// 남아 다시 접근하면 0으로 채워진 페이지를 받음. 프로그램, mmap, shmmap으로 매핑한
+// 구간과 겹치면 -1 (매핑은 munmap으로 없앰)
+int
+sys_ssurelease(void)
+{
+  int addr, size;
+  struct proc *curproc = myproc();
+
+  if(argint(0, &addr) < 0 || argint(1, &size) < 0)
+    return -1;
+  if(addr % PGSIZE || size <= 0 || size % PGSIZE ||
+     (uint)addr + size > curproc->sz || (uint)addr + size < (uint)addr)
+    return -1;
+  if(vma_overlap(curproc, addr, addr + size))
+    return -1;
+  return vm_ssurelease(curproc->pgdir, addr, addr + size);
+}
+
+// 키 key의 공유 메모리 세그먼트를 주소 공간 끝에 size 바이트만큼 매핑하고 시작 주소를
+// 반환. 없으면 새로 만들고, key가 0이면 fork한 자식하고만 공유하는 새 세그먼트.
+// 페이지는 처음 접근할 때 할당되며 munmap으로 매핑을 없앰
+int
+sys_shmmap(void)
+{
+  int key, size, addr;
+  struct shm *s;
+
+  if(argint(0, &key) < 0 || argint(1, &size) < 0 || key < 0 || size <= 0)
+    return -1;
+  if((s = shm_get(key, PGROUNDUP((uint)size) / PGSIZE)) == 0)
+    return -1;
+  addr = vm_mmap(myproc(), 0, s, 0, size, MAP_SHARED);
+  shm_put(s); // 매핑한 vma가 따로 참조를 잡음
+  return addr;
+}
+
+// 스왑 통계 4개를 복사. swap.c의 swapstat 참고
+int
+sys_swapstat(void)
+{
+  uint *st;
+
+  if(argptr(0, (void*)&st, 4*sizeof(uint)) < 0)
+    return -1;
+  swapstat(st);
+  return 0;
+}
+
+// 지금까지 처리한 페이지 폴트 수
+int
+sys_getpf(void)
+{
+  return myproc()->nfault;
+}
+
+// 차수별 빈 블록 수(MAXORDER+2개)를 복사. kalloc.c의 kmemstat 참고
+int
+sys_kmemstat(void)
+{
+  int *nfree;
+
+  if(argptr(0, (char**)&nfree, (MAXORDER+2)*sizeof(int)) < 0)
+    return -1;
+  kmemstat(nfree);
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+
+// 스왑 스트레스 테스트
+// 빈 물리 메모리의 두 배만큼 ssualloc으로 받아 순서대로 NROUND번, 무작위로 NRAND번 쓴다.
+// 각 단계의 페이지 폴트 수, 초당 폴트 수, 스왑으로 내보내거나 읽어 들인 페이지 수를 출력하고
+// 마지막에 모든 페이지의 내용이 맞는지 확인한다.
+// 사용법: thrash [MB]
+
+#define PGSIZE 4096
+#define NROUND 2
+#define NRAND 20000
+#define TICKHZ 100	// 초당 타이머 tick
+
+int freepages(void)
+{
+	int nfree[MAXORDER+2];
+	int k, total = 0;
+
+	kmemstat(nfree);
+	for(k = 0; k <= MAXORDER; k++)
+		total += nfree[k] << k;
+	return total + nfree[MAXORDER+1];
+}
+
+uint st0[4];
+uint pf0, t0;
+
+void start(void)
+{
+	swapstat(st0);
+	pf0 = getpf();
+	t0 = uptime();
+}
+
+void report(char *name)
+{
+	uint st[4];
+	uint pf, t;
+
+	swapstat(st);
+	pf = getpf() - pf0;
+	t = uptime() - t0;
+	if(t == 0) // 0으로 나누지 않도록
+		t = 1;
+	printf(1, "%s: %d faults in %d ticks (%d faults/sec), swap out %d, swap in %d, slots used %d/%d\n",
+		name, pf, t, pf * TICKHZ / t, st[2] - st0[2], st[3] - st0[3], st[1], st[0]);
+}
+
+int main(int argc, char *argv[])
+{
+	char *addr;
+	int npages, i, r, ok;
+	uint x = 1;
+
+	if(argc > 1)
+		npages = atoi(argv[1]) * 256;
+	else
+		npages = 2 * freepages();
+	printf(1, "thrash: %d pages (%d MB), %d pages free\n", npages, npages / 256, freepages());
+
+	addr = (char*)ssualloc(npages*PGSIZE, 0);
+	if((int)addr < 0) {
+		printf(1, "thrash: ssualloc failed\n");
+		exit();
+	}
+
+	start();
+	for(r = 0; r < NROUND; r++)
+		for(i = 0; i < npages; i++)
+			addr[i*PGSIZE] = (char)(i + r);
+	report("sequential");
+
+	start();
+	for(i = 0; i < NRAND; i++) {
+		x = x * 1103515245 + 12345;
+		r = (x >> 8) % npages;
+		addr[r*PGSIZE + 1] = addr[r*PGSIZE];
+	}
+	report("random");
+
+	ok = 1;
+	start();
+	for(i = 0; i < npages; i++)
+		if(addr[i*PGSIZE] != (char)(i + NROUND - 1))
+			ok = 0;
+	report("verify");
+	printf(1, "thrash: data %s\n", ok ? "ok" : "FAILED");
+	exit();
+}
@@ -78,8 +78,10 @@ trap(struct trapframe *tf)
     lapiceoi();
     break;
   case T_PGFLT:
-    ssu_palloc(myproc()->pgdir, rcr2());
-    break;
+    if(myproc() && vm_pgfault(myproc(), rcr2(), tf->err) == 0)
+      break;
+    // 처리할 수 없는 폴트는 아래에서 프로세스를 종료(커널이라면 panic)
+    // fall through
 
   //PAGEBREAK: 13
   default:
@@ -24,9 +24,17 @@ char* sbrk(int);
 int sleep(int);
 int uptime(void);
 // 추가
-int ssualloc(int);
+int ssualloc(int, int);
 int getvp(void);
 int getpp(void);
+int kmemstat(int*);
+int getpf(void);
+int ssurelease(void*, int);
+int swapstat(uint*);
+void* mmap(int, int, int, int);
+int munmap(void*, int);
+int fsync(int);
+void* shmmap(int, int);
 
 // ulib.c
 int stat(const char*, struct stat*);
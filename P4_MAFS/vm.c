@@ -6,9 +6,13 @@
 #include "mmu.h"
 #include "proc.h"
 #include "elf.h"
+#include "stat.h"
 
 extern char data[];  // defined by kernel.ld
 pde_t *kpgdir;  // for use in scheduler()
+char *zeropage; // 0으로 채워진 공유 페이지. ssualloc 페이지의 첫 읽기에 읽기 전용으로 매핑
+
+#define SPORDER 10 // 4MB 페이지 하나의 buddy 차수. SPSIZE == PGSIZE << SPORDER
 
 // Set up CPU's kernel segment descriptors.
 // Run once on entry on each CPU.
@@ -36,6 +40,43 @@ seginit(void)
 // Return the address of the PTE in page table pgdir
 // that corresponds to virtual address va.  If alloc!=0,
 // create any required page table pages.
+// 4MB 페이지(PTE_PS)를 같은 물리 페이지를 가리키는 4KB 페이지 테이블로 바꿈.
+// 각 4KB 페이지는 kalloc_pages에서 참조 수를 따로 받았으므로 이후 하나씩 kfree할 수 있음.
+// 번역 결과가 같으므로 TLB를 비울 필요는 없음. 메모리가 없으면 -1
+static int
+sp_split(pde_t *pde)
+{
+  pte_t *pgtab;
+  uint pa, flags;
+  int i;
+
+  if((pgtab = (pte_t*)kalloc()) == 0)
+    return -1;
+  pa = PTE_ADDR(*pde);
+  flags = PTE_FLAGS(*pde) & ~PTE_PS;
+  for(i = 0; i < NPTENTRIES; i++)
+    pgtab[i] = (pa + i*PGSIZE) | flags;
+  *pde = V2P(pgtab) | PTE_P | PTE_W | PTE_U;
+  return 0;
+}
+
+// 주소 a에서 시작하는 4MB가 [a, end) 안에 있고 비어있다면 연속된 물리 메모리로
+// 4MB 페이지를 매핑. 매핑했으면 1, 정렬이 맞지 않거나 메모리가 없으면 0
+static int
+sp_alloc(pde_t *pgdir, uint a, uint end)
+{
+  char *mem;
+
+  if(a % SPSIZE || end - a < SPSIZE || (pgdir[PDX(a)] & PTE_P))
+    return 0;
+  if((mem = kalloc_pages(SPORDER)) == 0) // 4KB 페이지로 대신함
+    return 0;
+  memset(mem, 0, SPSIZE);
+  pgdir[PDX(a)] = V2P(mem) | PTE_PS | PTE_P | PTE_W | PTE_U;
+  return 1;
+}
+
+// 4MB 페이지를 가리키는 pde는 먼저 4KB 페이지 테이블로 쪼갬. 쪼갤 메모리가 없으면 0
 static pte_t *
 walkpgdir(pde_t *pgdir, const void *va, int alloc)
 {
@@ -43,6 +84,8 @@ walkpgdir(pde_t *pgdir, const void *va, int alloc)
   pte_t *pgtab;
 
   pde = &pgdir[PDX(va)]; // 가상주소에서 페이지 디렉토리 인덱스를 추출해 해당 가상주소의 페이지 디렉토리 엔트리를 가져옴
+  if((*pde & PTE_PS) && sp_split(pde) < 0)
+    return 0;
   if(*pde & PTE_P){ // 해당 페이지 디렉토리 엔트리가 가리키는 pte가 존재한다면
     pgtab = (pte_t*)P2V(PTE_ADDR(*pde)); // 해당 pte가 가리키는 값의 하위 12비트(offset)을 제외한뒤 가상주소로 변환. 페이지 테이블이 됨. cpu는 가상주소로 넣어줘야하기에?
   } else { // 해당 페이지 디렉토리 엔트리가 가리키는 페이지가 존재하지 않는다면
@@ -124,27 +167,50 @@ static struct kmap {
  { (void*)DEVSPACE, DEVSPACE,      0,         PTE_W}, // more devices
 };
 
+// 커널 영역 매핑 하나를 kpgdir에 만듦. 가상/물리 주소가 모두 4MB로 정렬된 구간은
+// 4MB 페이지로, 나머지(커널 텍스트가 있는 첫 4MB 등)는 4KB 페이지로 매핑.
+// 모든 CPU와 프로세스가 같은 매핑을 쓰므로 PTE_G를 붙여 cr3를 바꿔도 TLB에 남게 함
+static void
+kmappages(struct kmap *k)
+{
+  char *a, *last;
+  uint pa;
+  pte_t *pte;
+
+  a = (char*)PGROUNDDOWN((uint)k->virt);
+  last = (char*)PGROUNDDOWN((uint)k->virt + k->phys_end - k->phys_start - 1);
+  for(pa = k->phys_start; a <= last && a >= (char*)k->virt; ){
+    if((uint)a % SPSIZE == 0 && pa % SPSIZE == 0 && last - a >= SPSIZE - PGSIZE &&
+       !(kpgdir[PDX(a)] & PTE_P)){
+      kpgdir[PDX(a)] = pa | k->perm | PTE_P | PTE_PS | PTE_G;
+      a += SPSIZE;
+      pa += SPSIZE;
+      continue;
+    }
+    if((pte = walkpgdir(kpgdir, a, 1)) == 0)
+      panic("kmappages");
+    if(*pte & PTE_P)
+      panic("remap");
+    *pte = pa | k->perm | PTE_P | PTE_G;
+    a += PGSIZE;
+    pa += PGSIZE;
+  }
+}
+
 // 오직 시스템 호출 및 인터럽트에서 사용하는 페이지 테이블.
-// 최초로 해당 프로세스만의 페이지 디렉토리를 만들고
-// 페이지 디렉토리, 페이지 테이블에 커널 관련 가상주소 - 피지컬 주소를 미리 매핑
+// 새 페이지 디렉토리를 만들고 커널 영역의 pde를 kpgdir에서 그대로 복사.
+// 커널 영역의 페이지 테이블은 모든 프로세스가 공유하므로 freevm에서 반환하지 않음
 // Set up kernel part of a page table.
 pde_t*
 setupkvm(void)
 {
   pde_t *pgdir;
-  struct kmap *k;
 
   if((pgdir = (pde_t*)kalloc()) == 0) // 페이지를 페이지 디렉토리로 쓰겠다
     return 0;
-  memset(pgdir, 0, PGSIZE);
-  if (P2V(PHYSTOP) > (void*)DEVSPACE)
-    panic("PHYSTOP too high");
-  for(k = kmap; k < &kmap[NELEM(kmap)]; k++)
-    if(mappages(pgdir, k->virt, k->phys_end - k->phys_start,
-                (uint)k->phys_start, k->perm) < 0) {
-      freevm(pgdir);
-      return 0;
-    }
+  memset(pgdir, 0, PDX(KERNBASE) * sizeof(pde_t));
+  memmove(&pgdir[PDX(KERNBASE)], &kpgdir[PDX(KERNBASE)],
+          (NPDENTRIES - PDX(KERNBASE)) * sizeof(pde_t));
   return pgdir;
 }
 
@@ -153,8 +219,19 @@ setupkvm(void)
 void
 kvmalloc(void)
 {
-  kpgdir = setupkvm();
+  struct kmap *k;
+
+  if (P2V(PHYSTOP) > (void*)DEVSPACE)
+    panic("PHYSTOP too high");
+  if((kpgdir = (pde_t*)kalloc()) == 0)
+    panic("kvmalloc");
+  memset(kpgdir, 0, PGSIZE);
+  for(k = kmap; k < &kmap[NELEM(kmap)]; k++)
+    kmappages(k);
   switchkvm();
+  if((zeropage = kalloc()) == 0)
+    panic("kvmalloc: zeropage");
+  memset(zeropage, 0, PGSIZE);
 }
 
 // Switch h/w page table register to the kernel-only page table,
@@ -190,6 +267,70 @@ switchuvm(struct proc *p)
   popcli();
 }
 
+// TLB 무효화.
+// 이미 있던 매핑을 바꾸거나 지웠을 때만 필요함(x86은 present가 아닌 항목을 TLB에 두지 않음).
+// 바뀐 페이지만 invlpg로 지움. 사용자 매핑에는 PTE_G가 없으므로 다른 CPU는 다른 프로세스로
+// 바꾸며 cr3를 읽을 때 이미 비워졌고, 스레드가 없어 한 pgdir은 그 프로세스가 도는 CPU
+// 하나에서만 쓰인다. 그래서 다른 CPU에 무효화를 요청(IPI)할 일이 없음. 한 주소 공간을
+// 여러 CPU가 함께 쓰게 되면 여기에 shootdown을 더해야 함
+#define TLBFULL 32 // 이보다 많은 페이지는 invlpg 대신 cr3를 다시 읽어 한 번에 지움
+
+// pgdir의 [start, end) 범위의 매핑을 바꾼 뒤 부름. 이 CPU가 pgdir을 쓰고 있을 때만 지우면 됨
+void
+tlb_shootdown(pde_t *pgdir, uint start, uint end)
+{
+  uint a;
+
+  pushcli(); // 확인하는 동안 다른 프로세스로 바뀌지 않게
+  if(rcr3() != V2P(pgdir)){
+    popcli();
+    return;
+  }
+  if(end - start > TLBFULL * PGSIZE)
+    lcr3(V2P(pgdir)); // PTE_G인 커널 항목은 남음
+  else
+    for(a = PGROUNDDOWN(start); a < end; a += PGSIZE)
+      invlpg((void*)a);
+  popcli();
+}
+
+// 페이지 테이블에서 뺀 물리 페이지를 모아 두었다가 TLB를 비운 다음 반환.
+// 무효화를 TLBBATCH 페이지마다 한 번으로 묶고, 지워지기 전의 TLB 항목으로 이미 반환된
+// 페이지에 접근하지 않게 함
+#define TLBBATCH 32
+
+struct tlbgather {
+  pde_t *pgdir;
+  uint start, end;         // 무효화할 범위. start == end면 없음
+  char *pages[TLBBATCH];   // 무효화 후 kfree할 페이지
+  int n;
+};
+
+static void
+tlb_finish(struct tlbgather *g)
+{
+  int i;
+
+  if(g->start != g->end)
+    tlb_shootdown(g->pgdir, g->start, g->end);
+  for(i = 0; i < g->n; i++)
+    kfree(g->pages[i]);
+  g->n = 0;
+  g->start = g->end = 0;
+}
+
+// 주소 va에 매핑되어 있던 페이지 v를 모음. va는 증가하는 순서로 줘야 함
+static void
+tlb_gather(struct tlbgather *g, uint va, char *v)
+{
+  if(g->n == TLBBATCH)
+    tlb_finish(g);
+  if(g->start == g->end)
+    g->start = va;
+  g->end = va + PGSIZE;
+  g->pages[g->n++] = v;
+}
+
 // Load the initcode into address 0 of pgdir.
 // sz must be less than a page.
 void
@@ -230,6 +371,447 @@ loaduvm(pde_t *pgdir, char *addr, struct inode *ip, uint offset, uint sz)
   return 0;
 }
 
+// 스왑.
+// 교체는 지역(local) 방식: 메모리가 모자라면 할당을 요청한 현재 프로세스의 페이지만
+// 내보낸다. 프로세스의 페이지 테이블은 여전히 그 프로세스만 바꾸므로 별도의 잠금 없이
+// 디스크를 기다리며 잠들 수 있음. 희생 페이지는 [0, sz)를 도는 clock(second chance)으로
+// 고르며, PTE_A가 켜진 페이지는 한 번 건너뛰고 PTE_A를 끔. 4MB 페이지, zero page, 다른 페이지
+// 테이블과 공유 중인 페이지는 내보내지 않음.
+// 스왑으로 나간 PTE는 present가 아니고 PTE_SWAP과 슬롯 번호, PTE_W|PTE_U 권한을 가짐
+
+#define SWAPSLOT(pte) (PTE_ADDR(pte) / PGSIZE)
+
+// 스핀락을 잡고 있지 않아 디스크를 기다리며 잠들 수 있는가
+static int
+can_sleep(void)
+{
+  int r;
+
+  pushcli();
+  r = mycpu()->ncli == 1;
+  popcli();
+  return r;
+}
+
+// 프로세스 p의 페이지 하나를 스왑으로 내보냄. 내보낼 페이지가 없거나 잠들 수 없으면 -1
+int
+swap_out(struct proc *p)
+{
+  pde_t *pgdir = p->pgdir;
+  pte_t *pte;
+  uint va, n, perm;
+  char *v;
+  int s;
+
+  if(!can_sleep())
+    return -1;
+  for(n = 0; n < 2 * (p->sz / PGSIZE); n++){ // 최대 두 바퀴
+    if(p->swaphand >= p->sz)
+      p->swaphand = 0;
+    va = p->swaphand;
+    if((pgdir[PDX(va)] & PTE_PS) || !(pgdir[PDX(va)] & PTE_P)){ // 다음 페이지 테이블로
+      p->swaphand = PGADDR(PDX(va) + 1, 0, 0);
+      continue;
+    }
+    p->swaphand = va + PGSIZE;
+    pte = (pte_t*)P2V(PTE_ADDR(pgdir[PDX(va)])) + PTX(va);
+    if((*pte & (PTE_P|PTE_U)) != (PTE_P|PTE_U))
+      continue;
+    v = P2V(PTE_ADDR(*pte));
+    if(v == zeropage || krefcnt(v) != 1)
+      continue;
+    if(*pte & PTE_A){ // 최근에 쓰인 페이지. 한 번 더 기회를 줌
+      *pte &= ~PTE_A;
+      continue;
+    }
+    if((s = swap_alloc()) < 0)
+      return -1;
+    perm = PTE_U | ((*pte & (PTE_W|PTE_COW)) ? PTE_W : 0); // 참조가 하나뿐이라 COW여도 자기 페이지
+    *pte = s * PGSIZE | PTE_SWAP | perm;
+    tlb_shootdown(pgdir, va, va + PGSIZE);
+    swap_write(s, v);
+    kfree(v);
+    return 0;
+  }
+  return -1;
+}
+
+// 사용자 페이지용 kalloc. 빈 페이지가 SWAPLOW보다 적거나 kalloc이 실패하면 page cache의
+// 페이지를 버리거나 현재 프로세스의 페이지를 하나 내보내고 할당
+static char*
+vm_kalloc(void)
+{
+  struct proc *p = myproc();
+  char *mem;
+
+  if(p && kfreepages() < SWAPLOW && pcache_shrink() < 0) // 매핑되지 않은 캐시 페이지부터 버림
+    swap_out(p);
+  if((mem = kalloc()) == 0 && (pcache_shrink() == 0 || (p && swap_out(p) == 0)))
+    mem = kalloc();
+  return mem;
+}
+
+// 스왑으로 나간 pte를 새 페이지로 읽어 들임. 잠들 수 없거나 메모리가 없으면 -1
+static int
+swap_in(pte_t *pte)
+{
+  char *mem;
+  int s;
+
+  if(!can_sleep() || (mem = vm_kalloc()) == 0)
+    return -1;
+  s = SWAPSLOT(*pte);
+  swap_read(s, mem);
+  swap_free(s);
+  // 막 읽어 들인 페이지가 바로 다시 희생되지 않도록 PTE_A를 켜 둠
+  *pte = V2P(mem) | (PTE_FLAGS(*pte) & (PTE_W|PTE_U)) | PTE_A | PTE_P;
+  return 0;
+}
+
+// 파일 매핑.
+// exec는 ELF 세그먼트를 읽지 않고 PTE만 예약한 뒤 struct vma에 파일 위치를 기록함.
+// 파일 내용이 있는 페이지는 present가 아닌 PTE_FILE로, 그 뒤의 bss는 ssualloc과 같은
+// 예약 상태로 둔다. PTE_FILE 페이지에 처음 접근하면 vma를 찾아 파일에서 새 페이지로
+// 읽어 들인다. 한 페이지를 모두 파일 내용으로 채우는 페이지는 page cache(pcache.c)의
+// 페이지를 읽기 전용으로 공유해 매핑하므로 같은 프로그램을 실행한 프로세스들이 같은 물리
+// 페이지를 씀. 쓰기 가능한 세그먼트면 PTE_COW로 매핑해 처음 쓸 때 복사함. 세그먼트 끝의
+// 일부만 파일인 페이지나 캐시에 자리가 없을 때는 새 페이지에 읽어 들이며, 그 페이지는
+// 일반 사용자 페이지처럼 COW, 스왑 대상이 됨.
+// mmap으로 만든 MAP_SHARED 구간은 캐시 페이지를 쓰기 가능하게 그대로 매핑하므로 같은 파일을
+// 매핑한 프로세스들과 writei가 같은 페이지를 본다. 매핑에 쓴 페이지는 PTE_D로 알 수 있고
+// munmap, fsync, exit, exec 때 vma_writeback이 로그를 거쳐 파일에 씀.
+// shmmap으로 만든 구간은 파일 대신 공유 메모리 세그먼트(shm.c)를 가리키며, PTE_FILE 페이지에
+// 처음 접근하면 세그먼트의 페이지를 (없으면 새로 0으로 채워 넣고) 쓰기 가능하게 매핑함.
+// vma는 inode나 세그먼트의 참조를 하나씩 잡고 있으므로 exec가 성공하거나 exit할 때
+// vma_release로 놓음
+
+// 사용 중인 vma인가
+static int
+vma_used(struct vma *v)
+{
+  return v->ip || v->shm;
+}
+
+// [start, end)를 파일 오프셋 off부터 filesz 바이트를 담는 구간으로 예약하고 v에 기록.
+// v->ip(또는 v->shm)와 v->flags는 호출한 쪽이 채움. 페이지 테이블을 만들 메모리가 없으면 -1
+int
+vm_mapfile(pde_t *pgdir, struct vma *v, uint start, uint end, uint off, uint filesz)
+{
+  pte_t *pte;
+  uint a;
+
+  for(a = start; a < end; a += PGSIZE){
+    if((pte = walkpgdir(pgdir, (char*)a, 1)) == 0)
+      return -1;
+    if(*pte)
+      panic("vm_mapfile: remap");
+    *pte = a - start < filesz ? PTE_FILE | PTE_W | PTE_U : PTE_W | PTE_U;
+  }
+  v->start = start;
+  v->end = end;
+  v->off = off;
+  v->filesz = filesz;
+  return 0;
+}
+
+// PTE_FILE인 pte를 p의 vma에서 찾은 파일 내용이나 공유 메모리 페이지로 채움. 잠들 수
+// 없거나 메모리가 없거나 파일을 읽지 못하면 -1
+static int
+file_in(struct proc *p, pte_t *pte, uint va)
+{
+  struct vma *v;
+  char *mem;
+  uint a, n;
+
+  a = PGROUNDDOWN(va);
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(vma_used(v) && a >= v->start && a < v->end)
+      break;
+  if(v == &p->vma[NVMA] || !can_sleep())
+    return -1;
+  if(v->shm){
+    n = (v->off + (a - v->start)) / PGSIZE;
+    if((mem = shm_page(v->shm, n, 0)) == 0){ // 아직 아무도 건드리지 않은 페이지
+      if((mem = vm_kalloc()) == 0)
+        return -1;
+      memset(mem, 0, PGSIZE);
+      mem = shm_page(v->shm, n, mem);
+    }
+    *pte = V2P(mem) | PTE_W | PTE_U | PTE_A | PTE_P;
+    return 0;
+  }
+  n = v->filesz - (a - v->start);
+  // 공유 매핑의 filesz는 파일 끝에서 잘렸으므로 마지막 페이지도 캐시 페이지(파일 끝 뒤는 0)
+  if((n >= PGSIZE || (v->flags & MAP_SHARED)) && (mem = pcache_get(v->ip, v->off + (a - v->start))) != 0){
+    if(v->flags & MAP_SHARED)
+      *pte = V2P(mem) | PTE_W | PTE_U | PTE_A | PTE_P;
+    else
+      *pte = V2P(mem) | PTE_U | ((*pte & PTE_W) ? PTE_COW : 0) | PTE_A | PTE_P;
+    return 0;
+  }
+  if(v->flags & MAP_SHARED) // 공유하려면 캐시 페이지여야 함. 캐시는 늘어나므로 메모리가 없거나 읽기 실패
+    return -1;
+  if(n > PGSIZE)
+    n = PGSIZE;
+  if((mem = vm_kalloc()) == 0)
+    return -1;
+  memset(mem, 0, PGSIZE); // 매핑한 뒤 파일이 줄어들었으면 모자란 부분은 0
+  ilock(v->ip);
+  if(readi(v->ip, mem, v->off + (a - v->start), n) < 0){
+    iunlock(v->ip);
+    kfree(mem);
+    return -1;
+  }
+  iunlock(v->ip);
+  *pte = V2P(mem) | (PTE_FLAGS(*pte) & (PTE_W|PTE_U)) | PTE_A | PTE_P;
+  return 0;
+}
+
+// [start, end)가 p의 파일이나 공유 메모리 매핑과 겹치는가. ssurelease는 익명 메모리만
+// 되돌릴 수 있음(공유 페이지를 놓으면 쓴 내용을 잃고 공유도 끊김)
+int
+vma_overlap(struct proc *p, uint start, uint end)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(vma_used(v) && start < v->end && end > v->start)
+      return 1;
+  return 0;
+}
+
+// fork에서 부모의 vma를 자식에게 복사. 파일과 세그먼트 참조도 하나씩 늘림
+void
+vma_dup(struct vma *dst, struct vma *src)
+{
+  int i;
+
+  for(i = 0; i < NVMA; i++){
+    dst[i] = src[i];
+    if(dst[i].ip)
+      idup(dst[i].ip);
+    if(dst[i].shm)
+      shm_dup(dst[i].shm);
+  }
+}
+
+// 공유 매핑 v의 [start, end)에서 pgdir로 쓴(PTE_D) 페이지를 파일에 씀. 파일 끝 뒤는
+// 쓰지 않으므로 매핑으로 파일이 커지지는 않음. 트랜잭션 밖에서 불러야 함
+static void
+vma_writeback(pde_t *pgdir, struct vma *v, uint start, uint end)
+{
+  // filewrite와 같은 이유로 트랜잭션 하나에 몇 블록씩만 씀
+  int max = ((MAXOPBLOCKS-1-1-2) / 2) * 512;
+  pte_t *pte;
+  uint a, off, i, n;
+  char *mem;
+  struct stat st;
+
+  if(!(v->flags & MAP_SHARED) || v->ip == 0)
+    return;
+  for(a = start; a < end; a += PGSIZE){
+    if((pte = walkpgdir(pgdir, (char*)a, 0)) == 0 || (*pte & (PTE_P|PTE_D)) != (PTE_P|PTE_D))
+      continue;
+    // 쓰기 전에 PTE_D를 꺼서 쓰는 동안 바뀐 내용은 다음 번에 다시 쓰게 함
+    *pte &= ~PTE_D;
+    tlb_shootdown(pgdir, a, a + PGSIZE);
+    mem = P2V(PTE_ADDR(*pte));
+    off = v->off + (a - v->start);
+    for(i = 0; i < PGSIZE; i += n){
+      n = PGSIZE - i < max ? PGSIZE - i : max;
+      begin_op();
+      ilock(v->ip);
+      stati(v->ip, &st);
+      if(off + i >= st.size)
+        n = 0;
+      else if(off + i + n > st.size)
+        n = st.size - (off + i);
+      if(n > 0)
+        writei(v->ip, mem + i, off + i, n);
+      iunlock(v->ip);
+      end_op();
+      if(n == 0)
+        break;
+    }
+  }
+}
+
+// vma 배열 v가 잡고 있는 파일, 세그먼트 참조를 모두 놓고 비움. 공유 매핑은 pgdir로 쓴
+// 내용을 먼저 파일에 씀(pgdir이 0이면 쓰지 않음). 트랜잭션 밖에서 불러야 함
+void
+vma_release(struct vma *v, pde_t *pgdir)
+{
+  int i, busy;
+
+  busy = 0;
+  for(i = 0; i < NVMA; i++){
+    if(v[i].shm){
+      shm_put(v[i].shm);
+      v[i].shm = 0;
+    }
+    if(v[i].ip == 0)
+      continue;
+    if(pgdir)
+      vma_writeback(pgdir, &v[i], v[i].start, v[i].end);
+    if(!busy){
+      begin_op();
+      busy = 1;
+    }
+    iput(v[i].ip);
+    v[i].ip = 0;
+  }
+  if(busy)
+    end_op();
+}
+
+// 파일 ip(또는 공유 메모리 세그먼트 s)의 오프셋 off부터 len 바이트를 p의 주소 공간 끝
+// (sz 뒤)에 매핑하고 시작 주소를 반환. 페이지는 처음 접근할 때 page cache나 세그먼트에서
+// 매핑됨. 파일 끝 뒤의 페이지는 파일과 상관없는 0 페이지. off가 파일 끝을 넘거나 빈 vma나
+// 메모리가 없으면 -1
+int
+vm_mmap(struct proc *p, struct inode *ip, struct shm *s, uint off, uint len, int flags)
+{
+  struct vma *v;
+  struct stat st;
+  uint start, end, filesz;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(!vma_used(v))
+      break;
+  if(v == &p->vma[NVMA])
+    return -1;
+  start = PGROUNDUP(p->sz);
+  end = start + PGROUNDUP(len);
+  if(end < start || end >= KERNBASE)
+    return -1;
+  filesz = end - start;
+  if(ip){ // 파일 끝 뒤의 페이지는 파일과 상관없는 0 페이지(예약 상태)로 둠
+    ilock(ip);
+    stati(ip, &st);
+    iunlock(ip);
+    if(off > st.size)
+      return -1;
+    filesz = st.size - off;
+    if(filesz > end - start)
+      filesz = end - start;
+  }
+  if(vm_mapfile(p->pgdir, v, start, end, off, filesz) < 0){
+    deallocuvm(p->pgdir, end, start);
+    return -1;
+  }
+  if(s){
+    shm_dup(s);
+    v->shm = s;
+  } else
+    v->ip = idup(ip);
+  v->flags = flags;
+  p->sz = end; // 없던 매핑만 생기므로 TLB를 비울 필요 없음
+  return start;
+}
+
+// [start, end)의 파일이나 공유 메모리 매핑을 없앰. 한 vma 안의 구간이어야 하고, 공유 매핑이면 쓴 내용을
+// 먼저 파일에 씀. 주소 공간 끝이면 sz를 줄이고, 중간이면 주소 공간에 구멍이 생기지
+// 않도록 ssurelease처럼 예약만 된 상태로 되돌림. 실패하면 -1
+int
+vm_munmap(struct proc *p, uint start, uint end)
+{
+  struct vma *v, *w;
+  pte_t *pte;
+  uint a;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(vma_used(v) && start >= v->start && start < v->end)
+      break;
+  if(v == &p->vma[NVMA] || end > v->end || end <= start)
+    return -1;
+  w = 0;
+  if(start > v->start && end < v->end){ // 가운데를 떼어내면 뒤쪽을 새 vma로
+    for(w = p->vma; w < &p->vma[NVMA]; w++)
+      if(!vma_used(w))
+        break;
+    if(w == &p->vma[NVMA])
+      return -1;
+  }
+  vma_writeback(p->pgdir, v, start, end);
+  if(end >= PGROUNDUP(p->sz)){
+    if(start < p->sz){ // sbrk로 이미 줄어들었을 수 있음
+      deallocuvm(p->pgdir, p->sz, start);
+      p->sz = start;
+    }
+  } else {
+    if(vm_ssurelease(p->pgdir, start, end) < 0)
+      return -1;
+    for(a = start; a < end; a += PGSIZE) // 읽지 않은 파일 페이지도 예약 상태로
+      if((pte = walkpgdir(p->pgdir, (char*)a, 0)) != 0 && (*pte & (PTE_P|PTE_FILE)) == PTE_FILE)
+        *pte = PTE_W | PTE_U;
+  }
+
+  if(w){
+    *w = *v;
+    w->start = end;
+    w->off = v->off + (end - v->start);
+    w->filesz = v->filesz > end - v->start ? v->filesz - (end - v->start) : 0;
+    if(w->ip)
+      idup(w->ip);
+    else
+      shm_dup(w->shm);
+  }
+  if(start == v->start && end == v->end){
+    if(v->shm){
+      shm_put(v->shm);
+      v->shm = 0;
+    } else {
+      begin_op();
+      iput(v->ip);
+      end_op();
+      v->ip = 0;
+    }
+  } else if(start == v->start){
+    v->off += end - start;
+    v->filesz = v->filesz > end - start ? v->filesz - (end - start) : 0;
+    v->start = end;
+  } else {
+    v->end = start;
+    if(v->filesz > start - v->start)
+      v->filesz = start - v->start;
+  }
+  return 0;
+}
+
+// p가 파일 ip를 공유 매핑한 구간에서 쓴 페이지를 모두 파일에 씀
+void
+vm_fsync(struct proc *p, struct inode *ip)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->ip == ip)
+      vma_writeback(p->pgdir, v, v->start, v->end);
+}
+
+// 시스템 호출이 넘겨받은 사용자 버퍼 [va, va+n)에서 스왑으로 나갔거나 아직 파일에서 읽지
+// 않은 페이지를 미리 읽어 들임. 파이프나 콘솔은 스핀락을 잡은 채 사용자 메모리를 읽고
+// 쓰는데, 그때 난 폴트에서는 디스크를 기다릴 수 없기 때문. 파일 시스템 호출도 inode를
+// 잠근 채 사용자 메모리를 건드리므로 그 안에서 다른 inode를 잠그지 않게 해 줌
+int
+vm_resident(struct proc *p, uint va, uint n)
+{
+  pte_t *pte;
+  uint a;
+
+  for(a = PGROUNDDOWN(va); a < va + n; a += PGSIZE){
+    if(p->pgdir[PDX(a)] & PTE_PS)
+      continue;
+    if((pte = walkpgdir(p->pgdir, (char*)a, 0)) == 0)
+      continue;
+    if((*pte & (PTE_P|PTE_SWAP)) == PTE_SWAP && swap_in(pte) < 0)
+      return -1;
+    if((*pte & (PTE_P|PTE_FILE)) == PTE_FILE && file_in(p, pte, a) < 0)
+      return -1;
+  }
+  return 0;
+}
+
 // 해당 크기만큼 메모리 공간을 넓혀줌
 // Allocate page tables and physical memory to grow process from oldsz to
 // newsz, which need not be page aligned.  Returns new size or 0 on error.
@@ -246,7 +828,11 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 
   a = PGROUNDUP(oldsz); // 페이지 반올림
   for(; a < newsz; a += PGSIZE){ // 페이지 단위로 newsz보다 커질때까지 반복해서 페이지 테이블 생성, 메모리 공간 생성 및 매핑
-    mem = kalloc(); // 자유 메모리에서 메모리 공간 할당. 해당 메모리의 가상 주소임
+    if(sp_alloc(pgdir, a, newsz)){ // 4MB 단위로 정렬된 부분은 4MB 페이지로
+      a += SPSIZE - PGSIZE;
+      continue;
+    }
+    mem = vm_kalloc(); // 자유 메모리에서 메모리 공간 할당. 해당 메모리의 가상 주소임
     if(mem == 0){ // 실패하면 이전꺼로 복구시킴
       cprintf("allocuvm out of memory\n");
       deallocuvm(pgdir, newsz, oldsz);
@@ -263,34 +849,78 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
   return newsz;
 }
 
+// 주소 a가 속한 페이지 테이블이 비었으면 pde를 지우고 테이블 페이지를 g에 모음.
+// 테이블을 캐시한 TLB 항목도 g를 비울 때 함께 무효화됨
+static void
+pgtab_free(pde_t *pgdir, uint a, struct tlbgather *g)
+{
+  pte_t *pgtab;
+  int i;
+
+  if(!(pgdir[PDX(a)] & PTE_P) || (pgdir[PDX(a)] & PTE_PS))
+    return;
+  pgtab = (pte_t*)P2V(PTE_ADDR(pgdir[PDX(a)]));
+  for(i = 0; i < NPTENTRIES; i++)
+    if(pgtab[i])
+      return;
+  pgdir[PDX(a)] = 0;
+  tlb_gather(g, a, (char*)pgtab);
+}
+
 // 여분의 크기만큼을 할당해제시키는듯
 // Deallocate user pages to bring the process size from oldsz to
 // newsz.  oldsz and newsz need not be page-aligned, nor does newsz
 // need to be less than oldsz.  oldsz can be larger than the actual
 // process size.  Returns the new process size.
+// 비게 된 페이지 테이블도 반환.
+// 4MB 페이지는 항상 [0, sz) 안에 통째로 있으므로 일부만 줄어드는 것은 newsz가 걸친 첫 4MB 페이지뿐.
+// 그 페이지를 쪼갤 메모리가 없으면 아무것도 바꾸지 않고 0
 int
 deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 {
   pte_t *pte;
   uint a, pa;
+  struct tlbgather g;
 
   if(newsz >= oldsz)
     return oldsz;
 
   a = PGROUNDUP(newsz);
+  if(a < oldsz && a % SPSIZE && (pgdir[PDX(a)] & PTE_PS) && sp_split(&pgdir[PDX(a)]) < 0)
+    return 0;
+  g.pgdir = pgdir;
+  g.start = g.end = 0;
+  g.n = 0;
   for(; a  < oldsz; a += PGSIZE){
+    if((pgdir[PDX(a)] & PTE_PS) && a % SPSIZE == 0){ // 4MB 페이지는 통째로 반환
+      pa = PTE_ADDR(pgdir[PDX(a)]);
+      pgdir[PDX(a)] = 0;
+      tlb_finish(&g);
+      tlb_shootdown(pgdir, a, a + SPSIZE);
+      kfree_pages(P2V(pa), SPORDER);
+      a += SPSIZE - PGSIZE;
+      continue;
+    }
     pte = walkpgdir(pgdir, (char*)a, 0);
-    if(!pte)
+    if(!pte){
       a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
-    else if((*pte & PTE_P) != 0){
+      continue;
+    }
+    if((*pte & PTE_P) != 0){
       pa = PTE_ADDR(*pte);
       if(pa == 0)
         panic("kfree");
-      char *v = P2V(pa);
-      kfree(v);
+      *pte = 0;
+      tlb_gather(&g, a, P2V(pa));
+    } else { // 아직 물리 페이지가 없거나 스왑으로 나간 ssualloc 페이지
+      if(*pte & PTE_SWAP)
+        swap_free(SWAPSLOT(*pte));
       *pte = 0;
     }
+    if(PTX(a) == NPTENTRIES-1 || a + PGSIZE >= oldsz)
+      pgtab_free(pgdir, a, &g);
   }
+  tlb_finish(&g);
   return newsz;
 }
 
@@ -305,7 +935,7 @@ freevm(pde_t *pgdir)
   if(pgdir == 0)
     panic("freevm: no pgdir");
   deallocuvm(pgdir, KERNBASE, 0);
-  for(i = 0; i < NPDENTRIES; i++){
+  for(i = 0; i < PDX(KERNBASE); i++){ // 커널 영역의 페이지 테이블은 공유하므로 그대로 둠
     if(pgdir[i] & PTE_P){
       char * v = P2V(PTE_ADDR(pgdir[i]));
       kfree(v);
@@ -329,36 +959,54 @@ clearpteu(pde_t *pgdir, char *uva)
 
 // 해당 페이지 테이블의 내용을 그대로 복사한 페이지 디렉토리를 리턴
 // 자식 프로세스를 위해 만드는듯
+// 물리 페이지는 복사하지 않고 부모와 자식이 함께 가리키게 함(copy-on-write).
+// 쓰기 가능한 페이지는 양쪽 모두 PTE_W를 지우고 PTE_COW를 표시해, 먼저 쓰는 쪽이
+// vm_pgfault에서 자신의 복사본을 받음. 물리 페이지가 없는 ssualloc 페이지는 그대로
+// 권한만 복사해 자식에서도 처음 접근할 때 할당된다. vma에서 MAP_SHARED인 구간 중
+// 파일(세그먼트)이 있는 페이지는 쓰기 권한을 그대로 둔 채 공유함.
+// pgdir은 현재 프로세스의 페이지 테이블이어야 함(부모의 PTE를 바꾼 뒤 TLB를 비움)
 // Given a parent process's page table, create a copy
 // of it for a child.
 pde_t*
-copyuvm(pde_t *pgdir, uint sz)
+copyuvm(pde_t *pgdir, uint sz, struct vma *vma)
 {
   pde_t *d;
-  pte_t *pte;
+  pte_t *pte, *npte;
   uint pa, i, flags;
-  char *mem;
+  struct vma *v;
 
   if((d = setupkvm()) == 0)
     return 0;
   for(i = 0; i < sz; i += PGSIZE){
+    // 4MB 페이지는 쪼개서 4KB 단위로 공유. 부모도 이후 4KB 페이지로 동작
+    if((pgdir[PDX(i)] & PTE_PS) && sp_split(&pgdir[PDX(i)]) < 0)
+      goto bad;
     if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
       panic("copyuvm: pte should exist");
-    if(!(*pte & PTE_P))
-      panic("copyuvm: page not present");
+    if(!(*pte & PTE_P)){ // ssualloc으로 예약만 된 페이지이거나 스왑으로 나간 페이지
+      if((npte = walkpgdir(d, (void *) i, 1)) == 0)
+        goto bad;
+      if(*pte & PTE_SWAP)
+        swap_dup(SWAPSLOT(*pte));
+      *npte = *pte;
+      continue;
+    }
+    for(v = vma; v < &vma[NVMA]; v++)
+      if(vma_used(v) && (v->flags & MAP_SHARED) && i >= v->start && i - v->start < v->filesz)
+        break;
+    if((*pte & PTE_W) && v == &vma[NVMA])
+      *pte = (*pte & ~PTE_W) | PTE_COW;
     pa = PTE_ADDR(*pte);
     flags = PTE_FLAGS(*pte);
-    if((mem = kalloc()) == 0)
-      goto bad;
-    memmove(mem, (char*)P2V(pa), PGSIZE);
-    if(mappages(d, (void*)i, PGSIZE, V2P(mem), flags) < 0) {
-      kfree(mem);
+    if(mappages(d, (void*)i, PGSIZE, pa, flags) < 0)
       goto bad;
-    }
+    kref(P2V(pa));
   }
+  tlb_shootdown(pgdir, 0, sz); // 부모의 쓰기 가능 TLB 항목 제거
   return d;
 
 bad:
+  tlb_shootdown(pgdir, 0, sz);
   freevm(d);
   return 0;
 }
@@ -414,7 +1062,9 @@ vm_getvp(pde_t *pgdir)
   if(pgdir == 0)
     panic("freevm: no pgdir");
   for(i = 0; i < PDX(KERNBASE); i++){ // 전체 페이지 디렉토리를 탐색
-    if(pgdir[i] & PTE_P){ // 만약 해당 페이지 디렉토리 엔트리가 존재할 경우
+    if(pgdir[i] & PTE_PS) // 4MB 페이지는 4KB 페이지 NPTENTRIES개로 셈
+      cnt += NPTENTRIES;
+    else if(pgdir[i] & PTE_P){ // 만약 해당 페이지 디렉토리 엔트리가 존재할 경우
       pgtab = (pte_t*)P2V(PTE_ADDR(pgdir[i])); // 페이지 디렉토리 엔트리가 가리키는 페이지 테이블을 꺼냄
       for(j = 0; j < NPTENTRIES; j++){
         if (pgtab[j]) // 할당한 가상 페이지가 있다면 카운트 증가
@@ -436,10 +1086,12 @@ vm_getpp(pde_t *pgdir)
   if(pgdir == 0)
     panic("freevm: no pgdir");
   for(i = 0; i < PDX(KERNBASE); i++){ // 커널 베이스 이전까지의 전체 페이지 디렉토리를 탐색
-    if(pgdir[i] & PTE_P){ // 만약 해당 페이지 디렉토리 엔트리가 존재할 경우
+    if(pgdir[i] & PTE_PS) // 4MB 페이지는 4KB 페이지 NPTENTRIES개로 셈
+      cnt += NPTENTRIES;
+    else if(pgdir[i] & PTE_P){ // 만약 해당 페이지 디렉토리 엔트리가 존재할 경우
       pgtab = (pte_t*)P2V(PTE_ADDR(pgdir[i])); // 페이지 디렉토리 엔트리가 가리키는 페이지 테이블을 꺼냄
       for(j = 0; j < NPTENTRIES; j++){
-        if (pgtab[j] & PTE_P) // 만약 페이지가 매핑이 되어있다면 카운트 증가
+        if ((pgtab[j] & PTE_P) && PTE_ADDR(pgtab[j]) != V2P(zeropage)) // 만약 페이지가 매핑이 되어있다면 카운트 증가. 공유 zero page는 제외
           cnt++;
       }
     }
@@ -491,26 +1143,189 @@ ssu_mappages(pde_t *pgdir, void *va, uint pa)
 }
 
 // 페이지 폴트가 발생한 가상 주소에 대해 딱 한개의 물리 페이지를 할당해줌
-// 페이지 폴트용
-void
+// 페이지 폴트용. 메모리가 부족하면 -1
+int
 ssu_palloc(pde_t *pgdir, uint va)
 {
   char *mem;
   uint a; // 실 할당 주소
   
   a = PGROUNDDOWN(va); // 페이지 크기 반내림. 주소는 무조건 내려야함
-  mem = kalloc(); // 자유 메모리에서 딱 한페이지의 메모리 공간 할당. 해당 메모리의 가상 주소임
-  if(mem == 0)
-    panic("allocuvm out of memory");
+  mem = vm_kalloc(); // 자유 메모리에서 딱 한페이지의 메모리 공간 할당. 해당 메모리의 가상 주소임
+  if(mem == 0){
+    cprintf("ssu_palloc out of memory\n");
+    return -1;
+  }
   memset(mem, 0, PGSIZE);
   if(ssu_mappages(pgdir, (char*)a, V2P(mem)) < 0){ // 페이지테이블에 가상-물리주소를 매핑. 실패시 패닉.
     kfree(mem);
     panic("palloc failed");
   }
+  return 0;
+}
+
+// copy-on-write 페이지에 대한 쓰기. 다른 프로세스와 공유 중이면 복사본을 만들어
+// 바꿔 끼우고, 마지막 사용자라면 복사 없이 쓰기 권한만 되돌림
+static int
+cow_copy(pte_t *pte)
+{
+  char *old, *mem;
+
+  old = P2V(PTE_ADDR(*pte));
+  if(old == zeropage || krefcnt(old) > 1){ // zero page는 참조 수와 상관없이 항상 복사
+    if((mem = vm_kalloc()) == 0){
+      cprintf("cow_copy out of memory\n");
+      return -1;
+    }
+    if(old == zeropage)
+      memset(mem, 0, PGSIZE);
+    else
+      memmove(mem, old, PGSIZE);
+    *pte = V2P(mem) | PTE_FLAGS(*pte);
+    kfree(old); // 공유하던 참조 하나 반환
+  }
+  *pte = (*pte | PTE_W) & ~PTE_COW;
+  return 0;
+}
+
+// 예약만 된 페이지를 공유 zero page에 매핑. 쓰기 권한이 있던 페이지는 copy-on-write로
+// 표시해 처음 쓸 때 cow_copy가 자신의 페이지를 할당함
+static void
+zeropage_map(pte_t *pte)
+{
+  uint flags = PTE_FLAGS(*pte);
+
+  if(flags & PTE_W)
+    flags = (flags & ~PTE_W) | PTE_COW;
+  kref(zeropage);
+  *pte = V2P(zeropage) | flags | PTE_P;
+}
+
+// ssualloc으로 예약한 영역 [start, end)를 기록. 가득 차면 가장 오래된 영역을 버림
+void
+ssu_addregion(struct proc *p, uint start, uint end)
+{
+  struct ssuregion *r;
+
+  if(p->nssureg == NSSUREGION){
+    memmove(p->ssureg, p->ssureg + 1, sizeof(p->ssureg[0]) * (NSSUREGION - 1));
+    p->nssureg--;
+  }
+  r = &p->ssureg[p->nssureg++];
+  r->start = start;
+  r->end = end;
+  r->next = -1; // 아직 접근 기록 없음
+  r->win = 1;
 }
 
+// va의 페이지부터 한 번의 폴트로 매핑할 페이지 수. readahead처럼 영역 안에서 직전
+// 폴트가 매핑한 바로 다음 페이지에 폴트가 나면 순차 접근으로 보고 창을 두 배로
+// (최대 SSUFAMAX) 늘리고, 그렇지 않으면 한 페이지로 되돌림
+static uint
+ssu_window(struct proc *p, uint va)
+{
+  struct ssuregion *r;
+  uint a, n;
+
+  a = PGROUNDDOWN(va);
+  for(r = p->ssureg; r < &p->ssureg[p->nssureg]; r++){
+    if(va < r->start || va >= r->end)
+      continue;
+    if(a == r->next)
+      r->win = r->win * 2 > SSUFAMAX ? SSUFAMAX : r->win * 2;
+    else
+      r->win = 1;
+    n = (PGROUNDUP(r->end) - a) / PGSIZE; // 영역을 넘지 않도록
+    if(n > r->win)
+      n = r->win;
+    r->next = a + n * PGSIZE;
+    return n;
+  }
+  return 1; // 기록되지 않은 영역
+}
+
+// 사용자 주소 va에서 난 페이지 폴트 처리. err는 trap의 오류 코드(FEC_*).
+// ssualloc으로 예약만 된 페이지를 읽으면 zero page를, 쓰면 물리 페이지를 할당하고,
+// copy-on-write 페이지에 쓰면 복사한다. 예약만 된 페이지는 ssu_window만큼 뒤의
+// 페이지까지 함께 매핑. 스왑이나 파일에 있는 페이지는 읽어 들임. 처리할 수 없는 접근이면 -1
+int
+vm_pgfault(struct proc *p, uint va, uint err)
+{
+  pde_t *pgdir = p->pgdir;
+  pte_t *pte;
+  uint a, i, n;
+
+  if(va >= KERNBASE || (pgdir[PDX(va)] & PTE_PS) ||
+     (pte = walkpgdir(pgdir, (char*)va, 0)) == 0 || *pte == 0)
+    return -1; // 할당받지 않은 주소. 4MB 페이지는 항상 쓰기 가능하므로 권한 위반
+  p->nfault++;
+  if(*pte & PTE_SWAP) // 스왑으로 나간 페이지는 읽어 들인 뒤 다시 접근하게 함
+    return swap_in(pte);
+  if(*pte & PTE_FILE) // 파일에서 읽어 들임
+    return file_in(p, pte, va);
+  if(!(*pte & PTE_P)){
+    n = ssu_window(p, va);
+    a = PGROUNDDOWN(va);
+    for(i = 0; i < n; i++, a += PGSIZE){
+      // 이웃 페이지는 예약만 된 페이지일 때만 매핑. 이미 매핑되었거나 스왑, 파일에 있는 페이지를 만나면 멈춤
+      if(i > 0 && ((pte = walkpgdir(pgdir, (char*)a, 0)) == 0 || *pte == 0 || (*pte & (PTE_P|PTE_SWAP|PTE_FILE))))
+        break;
+      if(!(err & FEC_WR))
+        zeropage_map(pte); // 새 매핑이므로 TLB를 비울 필요 없음
+      else if(ssu_palloc(pgdir, a) < 0)
+        return i > 0 ? 0 : -1; // 폴트가 난 페이지만 할당되면 성공
+    }
+    return 0;
+  }
+  if((err & FEC_WR) && (*pte & PTE_COW)){
+    if(cow_copy(pte) < 0)
+      return -1;
+    tlb_shootdown(pgdir, PGROUNDDOWN(va), PGROUNDDOWN(va) + PGSIZE); // 읽기 전용 TLB 항목 제거
+    return 0;
+  }
+  return -1;
+}
+
+// [start, end)의 물리 페이지를 반환하고 ssualloc으로 예약만 된 상태로 되돌림. 가상 주소는
+// 그대로 남아 다음 접근 때 vm_pgfault가 zero page나 새 페이지를 매핑함. 쓰기 가능한
+// (copy-on-write 포함) 사용자 페이지만 되돌리고 나머지는 그대로 둠. 메모리가 없어
+// 4MB 페이지를 쪼개지 못하면 -1
 int
-vm_ssualloc(pde_t *pgdir, uint oldsz, uint newsz)
+vm_ssurelease(pde_t *pgdir, uint start, uint end)
+{
+  pte_t *pte;
+  uint a;
+  struct tlbgather g;
+
+  g.pgdir = pgdir;
+  g.start = g.end = 0;
+  g.n = 0;
+  for(a = start; a < end; a += PGSIZE){
+    if((pgdir[PDX(a)] & PTE_PS) && sp_split(&pgdir[PDX(a)]) < 0){
+      tlb_finish(&g);
+      return -1;
+    }
+    if((pte = walkpgdir(pgdir, (char*)a, 0)) == 0){
+      a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
+      continue;
+    }
+    if((*pte & (PTE_P|PTE_SWAP)) == PTE_SWAP){ // 스왑 슬롯만 반환
+      swap_free(SWAPSLOT(*pte));
+      *pte = PTE_W | PTE_U;
+      continue;
+    }
+    if(!(*pte & PTE_P) || !(*pte & PTE_U) || !(*pte & (PTE_W|PTE_COW)))
+      continue;
+    tlb_gather(&g, a, P2V(PTE_ADDR(*pte)));
+    *pte = PTE_W | PTE_U; // ssu_valloc과 같은 예약 상태
+  }
+  tlb_finish(&g);
+  return 0;
+}
+
+// flags에 SSU_POPULATE가 있으면 예약한 페이지를 바로 모두 할당(폴트 없음)
+int
+vm_ssualloc(pde_t *pgdir, uint oldsz, uint newsz, int flags)
 {
   uint a;
 
@@ -519,8 +1334,17 @@ vm_ssualloc(pde_t *pgdir, uint oldsz, uint newsz)
 
   a = PGROUNDUP(oldsz); // 페이지 반올림
   for(; a < newsz; a += PGSIZE){ // 페이지 단위로 newsz보다 커질때까지 반복해서 페이지 테이블 생성, 메모리 공간 생성 및 매핑
+    if((flags & SSU_POPULATE) && sp_alloc(pgdir, a, newsz)){ // 미리 할당할 때는 4MB 페이지도 사용
+      a += SPSIZE - PGSIZE;
+      continue;
+    }
     if(ssu_valloc(pgdir, (char*)a, PGSIZE, PTE_W|PTE_U) < 0){ // 페이지 디렉토리, 페이지 테이블에 할당받은 메모리를 가상메모리만 매핑시켜버림
       cprintf("allocuvm out of memory (2)\n");
+      deallocuvm(pgdir, a, oldsz);
+      return -1;
+    }
+    if((flags & SSU_POPULATE) && ssu_palloc(pgdir, a) < 0){
+      deallocuvm(pgdir, a + PGSIZE, oldsz);
       return -1;
     }
   }
@@ -130,6 +130,19 @@ xchg(volatile uint *addr, uint newval)
   return result;
 }
 
+// Atomically add v to *addr and return the new value.
+static inline int
+atomic_add(volatile int *addr, int v)
+{
+  int old = v;
+
+  asm volatile("lock; xaddl %0, %1" :
+               "+r" (old), "+m" (*addr) :
+               :
+               "memory", "cc");
+  return old + v;
+}
+
 static inline uint
 rcr2(void)
 {
@@ -144,6 +157,21 @@ lcr3(uint val)
   asm volatile("movl %0,%%cr3" : : "r" (val));
 }
 
+static inline uint
+rcr3(void)
+{
+  uint val;
+  asm volatile("movl %%cr3,%0" : "=r" (val));
+  return val;
+}
+
+// Invalidate the TLB entry for the page containing va.
+static inline void
+invlpg(void *va)
+{
+  asm volatile("invlpg (%0)" : : "r" (va) : "memory");
+}
+
 //PAGEBREAK: 36
 // Layout of the trap frame built on the stack by the
 // hardware and by trapasm.S, and passed to trap().
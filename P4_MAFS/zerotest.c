@@ -0,0 +1,57 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// 공유 zero page 테스트
+// 1. ssualloc으로 예약한 영역을 읽기만 하면 물리 페이지가 늘지 않는지
+// 2. 읽은 뒤 쓰면 쓴 페이지만큼 물리 페이지가 할당되고 값이 0에서 시작하는지
+// 3. 같은 크기를 sbrk로 받아 읽는 경우(eager)와 물리 페이지 수, 시간 비교
+
+#define PGSIZE 4096
+#define NPAGES 512	// 2MB
+#define NROUND 20
+
+int main(void)
+{
+	char *lazy, *eager;
+	int i, r, before, ok, sum;
+	uint start;
+
+	before = getpp();
+	lazy = (char*)ssualloc(NPAGES*PGSIZE, 0);
+	if((int)lazy < 0) {
+		printf(1, "zerotest: ssualloc failed\n");
+		exit();
+	}
+	sum = 0;
+	start = uptime();
+	for(r = 0; r < NROUND; r++)
+		for(i = 0; i < NPAGES; i++)
+			sum += lazy[i*PGSIZE];
+	printf(1, "lazy read %d pages: physical pages +%d, virtual pages %d, %d ticks\n",
+		NPAGES, getpp() - before, getvp(), uptime() - start);
+
+	ok = sum == 0;
+	for(i = 0; i < NPAGES; i += 2) // 절반의 페이지에만 씀
+		lazy[i*PGSIZE] += i;
+	for(i = 0; i < NPAGES; i++)
+		if(lazy[i*PGSIZE] != (i % 2 ? 0 : (char)i))
+			ok = 0;
+	printf(1, "lazy write %d pages: physical pages +%d, data %s\n",
+		NPAGES/2, getpp() - before, ok ? "ok" : "FAILED");
+
+	before = getpp();
+	eager = sbrk(NPAGES*PGSIZE);
+	if(eager == (char*)-1) {
+		printf(1, "zerotest: sbrk failed\n");
+		exit();
+	}
+	sum = 0;
+	start = uptime();
+	for(r = 0; r < NROUND; r++)
+		for(i = 0; i < NPAGES; i++)
+			sum += eager[i*PGSIZE];
+	printf(1, "eager read %d pages: physical pages +%d, %d ticks\n",
+		NPAGES, getpp() - before, uptime() - start);
+	exit();
+}
@@ -115,6 +115,87 @@ found:
   return p;
 }
 
+//PAGEBREAK: 20
+// Per-cpu run queues.
+// Each cpu keeps a FIFO of its RUNNABLE processes so that
+// scheduler() takes the next process without scanning ptable.
+// A process goes back to the queue of the cpu it last ran on;
+// an idle cpu steals from the peer with the longest queue.
+// runqput and runqget must be called with ptable.lock held.
+// The queues have no locks of their own: ptable.lock also guards
+// p->state and sleep/wakeup and is held across swtch(), so every
+// queue operation is already serialised by it. Giving the queues
+// their own locks would need per-process locks first.
+// runqbusiest and runqidlest only read queue lengths, so they
+// take no lock and are called before ptable.lock is acquired.
+
+// Append p to the run queue of cpu p->cpu.
+static void
+runqput(struct proc *p)
+{
+  struct cpu *c = &cpus[p->cpu];
+
+  p->rqnext = 0;
+  if(c->runq == 0)
+    c->runq = p;
+  else
+    c->runqtail->rqnext = p;
+  c->runqtail = p;
+  c->nrunnable++;
+}
+
+// Remove and return the head of c's run queue, or 0 if empty.
+static struct proc*
+runqget(struct cpu *c)
+{
+  struct proc *p;
+
+  if((p = c->runq) == 0)
+    return 0;
+  c->runq = p->rqnext;
+  if(c->runq == 0)
+    c->runqtail = 0;
+  p->rqnext = 0;
+  c->nrunnable--;
+  return p;
+}
+
+// Return the peer of c with the most runnable processes,
+// or 0 if every peer's run queue is empty.
+static struct cpu*
+runqbusiest(struct cpu *c)
+{
+  struct cpu *peer, *busiest = 0;
+
+  for(peer = cpus; peer < &cpus[ncpu]; peer++){
+    if(peer == c || peer->nrunnable == 0)
+      continue;
+    if(busiest == 0 || peer->nrunnable > busiest->nrunnable)
+      busiest = peer;
+  }
+  return busiest;
+}
+
+// Return the index of the least loaded cpu, preferring this one.
+// Must be called with interrupts disabled.
+static int
+runqidlest(void)
+{
+  struct cpu *c, *best;
+  int load, bestload;
+
+  best = mycpu();
+  bestload = best->nrunnable + (best->proc != 0);
+  for(c = cpus; c < &cpus[ncpu]; c++){
+    load = c->nrunnable + (c->proc != 0);
+    if(load < bestload){
+      best = c;
+      bestload = load;
+    }
+  }
+  return best - cpus;
+}
+
 //PAGEBREAK: 32
 // Set up first user process.
 void
@@ -149,6 +230,8 @@ userinit(void)
   acquire(&ptable.lock);
 
   p->state = RUNNABLE;
+  p->cpu = 0;
+  runqput(p);
 
   release(&ptable.lock);
 }
@@ -180,7 +263,7 @@ growproc(int n)
 int
 fork(void)
 {
-  int i, pid;
+  int i, pid, cpu;
   struct proc *np;
   struct proc *curproc = myproc();
 
@@ -212,9 +295,15 @@ fork(void)
 
   pid = np->pid;
 
+  pushcli();
+  cpu = runqidlest();
+  popcli();
+
   acquire(&ptable.lock);
 
   np->state = RUNNABLE;
+  np->cpu = cpu;
+  runqput(np);
 
   release(&ptable.lock);
 
@@ -324,21 +413,29 @@ scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  struct cpu *peer;
   c->proc = 0;
   
   for(;;){
     // Enable interrupts on this processor.
     sti();
 
-    // Loop over process table looking for process to run.
-    acquire(&ptable.lock);
-    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-      if(p->state != RUNNABLE)
-        continue;
+    // Pick the queue to take from without holding a lock: our
+    // own, or else the busiest peer's. Idle cpus then do not keep
+    // ptable.lock bouncing between them, and the scan over the
+    // cpus never runs with ptable.lock held. If the queue has
+    // emptied by the time we lock it, just go around again.
+    if(c->nrunnable)
+      peer = c;
+    else if((peer = runqbusiest(c)) == 0)
+      continue;
 
+    acquire(&ptable.lock);
+    if((p = runqget(peer)) != 0){
       // Switch to chosen process.  It is the process's job
       // to release ptable.lock and then reacquire it
       // before jumping back to us.
+      p->cpu = c - cpus;
       c->proc = p;
       switchuvm(p);
       p->state = RUNNING;
@@ -387,6 +484,7 @@ yield(void)
 {
   acquire(&ptable.lock);  //DOC: yieldlock
   myproc()->state = RUNNABLE;
+  runqput(myproc());
   sched();
   release(&ptable.lock);
 }
@@ -460,8 +558,10 @@ wakeup1(void *chan)
   struct proc *p;
 
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == SLEEPING && p->chan == chan)
+    if(p->state == SLEEPING && p->chan == chan){
       p->state = RUNNABLE;
+      runqput(p);
+    }
 }
 
 // Wake up all processes sleeping on chan.
@@ -486,8 +586,10 @@ kill(int pid)
     if(p->pid == pid){
       p->killed = 1;
       // Wake process from sleep if necessary.
-      if(p->state == SLEEPING)
+      if(p->state == SLEEPING){
         p->state = RUNNABLE;
+        runqput(p);
+      }
       release(&ptable.lock);
       return 0;
     }
@@ -8,6 +8,9 @@ struct cpu {
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
   struct proc *proc;           // The process running on this cpu or null
+  struct proc *runq;           // Head of this cpu's run queue
+  struct proc *runqtail;       // Tail of this cpu's run queue
+  volatile int nrunnable;      // Number of processes on runq
 };
 
 extern struct cpu cpus[NCPU];
@@ -49,6 +52,8 @@ struct proc {
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
   char name[16];               // Process name (debugging)
+  struct proc *rqnext;         // Next process on the run queue
+  int cpu;                     // Index of the cpu whose run queue p uses
 };
 
 // Process memory is laid out contiguously, low addresses first: